@@ -36,6 +36,12 @@ using namespace std;
 
 BalMod::BalMod(GraphBin& gr, long double max_w) : Quality(gr, "Balanced Modularity"), max(max_w)
 {
+    reset();
+}
+
+void BalMod::reset()
+{
+    size = g.nb_nodes;
     n2c.resize(size);
 
     in.resize(size);
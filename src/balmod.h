@@ -49,6 +49,8 @@ class BalMod : public Quality
     BalMod(GraphBin& gr, long double max_w);
     ~BalMod();
 
+    void reset();
+
     inline void remove(int node, int comm, long double dnodecomm);
 
     inline void insert(int node, int comm, long double dnodecomm);
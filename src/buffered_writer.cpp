@@ -0,0 +1,73 @@
+// File: buffered_writer.cpp
+// -- buffered text and binary output source file
+//-----------------------------------------------------------------------------
+// Community detection
+// Copyright (C) 2020 Mate Soos
+//
+// This file is part of Louvain algorithm.
+//
+// Louvain algorithm is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Louvain algorithm is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Louvain algorithm.  If not, see <http://www.gnu.org/licenses/>.
+//-----------------------------------------------------------------------------
+// see README.txt for more details
+
+#include "buffered_writer.h"
+
+#include <algorithm>
+
+using namespace std;
+
+BufferedWriter::BufferedWriter(ostream& _out, size_t size) : out(_out), buf(max(size, (size_t)64)), pos(0)
+{
+}
+
+BufferedWriter::~BufferedWriter()
+{
+    flush();
+}
+
+void BufferedWriter::put(const char *data, size_t size)
+{
+    if (buf.size() - pos < size) {
+        flush();
+        if (size >= buf.size()) {
+            out.write(data, size);
+            return;
+        }
+    }
+    memcpy(&buf[pos], data, size);
+    pos += size;
+}
+
+void BufferedWriter::flush()
+{
+    if (pos > 0)
+        out.write(buf.data(), pos);
+    pos = 0;
+    out.flush();
+}
+
+void write_partition(ostream& out, const int *comm, size_t nb_nodes, bool binary)
+{
+    BufferedWriter w(out);
+    for (size_t node = 0; node < nb_nodes; node++) {
+        if (binary) {
+            w.put_int32(comm[node]);
+        } else {
+            w.put_int((long long)node);
+            w.put_char(' ');
+            w.put_int(comm[node]);
+            w.put_char('\n');
+        }
+    }
+}
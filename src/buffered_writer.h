@@ -0,0 +1,113 @@
+// File: buffered_writer.h
+// -- buffered text and binary output header file
+//-----------------------------------------------------------------------------
+// Community detection
+// Copyright (C) 2020 Mate Soos
+//
+// This file is part of Louvain algorithm.
+//
+// Louvain algorithm is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Louvain algorithm is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Louvain algorithm.  If not, see <http://www.gnu.org/licenses/>.
+//-----------------------------------------------------------------------------
+// see README.txt for more details
+
+#ifndef LOUVAIN_BUFFEREDWRITER_H
+#define LOUVAIN_BUFFEREDWRITER_H
+
+#include <stdint.h>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// formats into a large buffer, written to the stream in big chunks when it
+// is full (and on flush / destruction) instead of once per line
+class BufferedWriter
+{
+   public:
+    BufferedWriter(ostream& out, size_t size = 1 << 20);
+    ~BufferedWriter();
+
+    inline void put_char(char c);
+    inline void put_int(long long v);
+    // 4 bytes, in the byte order of the machine
+    inline void put_int32(int32_t v);
+    void put(const char *data, size_t size);
+
+    void flush();
+
+   private:
+    BufferedWriter(const BufferedWriter &);
+    BufferedWriter &operator=(const BufferedWriter &);
+
+    ostream& out;
+    vector<char> buf;
+    size_t pos;
+};
+
+// writes the community of each node: "node community" lines, or (binary) an
+// array of 4 bytes communities in the byte order of the machine
+void write_partition(ostream& out, const int *comm, size_t nb_nodes, bool binary = false);
+
+inline void BufferedWriter::put_char(char c)
+{
+    if (pos == buf.size())
+        flush();
+    buf[pos++] = c;
+}
+
+inline void BufferedWriter::put_int(long long v)
+{
+    static const char digits[201] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+    if (buf.size() - pos < 24)
+        flush();
+
+    unsigned long long u = (v < 0) ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+    if (v < 0)
+        buf[pos++] = '-';
+
+    // two digits at a time, from the end
+    char tmp[24];
+    char *p = tmp + sizeof(tmp);
+    while (u >= 100) {
+        unsigned i = (unsigned)(u % 100) * 2;
+        u /= 100;
+        *--p = digits[i + 1];
+        *--p = digits[i];
+    }
+    if (u >= 10) {
+        *--p = digits[u * 2 + 1];
+        *--p = digits[u * 2];
+    } else {
+        *--p = (char)('0' + u);
+    }
+
+    size_t n = tmp + sizeof(tmp) - p;
+    memcpy(&buf[pos], p, n);
+    pos += n;
+}
+
+inline void BufferedWriter::put_int32(int32_t v)
+{
+    if (buf.size() - pos < sizeof(v))
+        flush();
+    memcpy(&buf[pos], &v, sizeof(v));
+    pos += sizeof(v);
+}
+
+#endif // LOUVAIN_BUFFEREDWRITER_H
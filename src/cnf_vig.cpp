@@ -0,0 +1,279 @@
+// File: cnf_vig.cpp
+// -- DIMACS CNF to variable incidence graph source file
+//-----------------------------------------------------------------------------
+// Community detection
+// Copyright (C) 2020 Mate Soos
+//
+// This file is part of Louvain algorithm.
+//
+// Louvain algorithm is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Louvain algorithm is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Louvain algorithm.  If not, see <http://www.gnu.org/licenses/>.
+//-----------------------------------------------------------------------------
+// see README.txt for more details
+
+#include "cnf_vig.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "edge_list.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+// the variables of one chunk of the file
+// ends[i] is the index in vars just after the i-th clause terminator of the
+// chunk. Clauses that start and end in the chunk are already sorted and
+// without duplicates; the one before ends[0] (its start may be in an earlier
+// chunk) and the one after ends.back() (unfinished) are not
+// once the chunks are put together, head holds the first clause of the
+// chunk (the one ending at ends[0]), sorted and without duplicates
+struct CnfChunk {
+    vector<uint32_t> vars;
+    vector<size_t> ends;
+    vector<uint32_t> head;
+    long long max_var;
+    const char *err;
+
+    CnfChunk() : max_var(0), err(NULL)
+    {
+    }
+
+    // the variables of clause i of the chunk, i < ends.size()
+    const uint32_t *clause_begin(size_t i) const
+    {
+        return (i == 0) ? head.data() : vars.data() + ends[i - 1];
+    }
+    const uint32_t *clause_end(size_t i) const
+    {
+        return (i == 0) ? head.data() + head.size() : vars.data() + ends[i];
+    }
+};
+
+static inline bool is_blank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static void normalize_clause(vector<uint32_t>& vars, size_t start)
+{
+    sort(vars.begin() + start, vars.end());
+    vars.erase(unique(vars.begin() + start, vars.end()), vars.end());
+}
+
+static void parse_chunk(const char *p, const char *end, CnfChunk& out)
+{
+    size_t clause_start = 0;
+    while (p < end) {
+        const char *line = p;
+        while (p < end && is_blank(*p))
+            p++;
+        if (p == end)
+            break;
+        if (*p == 'c' || *p == 'p' || *p == '%') {
+            const char *nl = (const char *)memchr(p, '\n', end - p);
+            p = nl ? nl + 1 : end;
+            continue;
+        }
+
+        while (p < end && *p != '\n') {
+            if (is_blank(*p)) {
+                p++;
+                continue;
+            }
+            if (*p == '-')
+                p++;
+            uint32_t var;
+            if (!scan_node(p, end, var) || var >= INT_MAX) {
+                out.err = line;
+                return;
+            }
+
+            if (var != 0) {
+                out.vars.push_back(var);
+                out.max_var = max(out.max_var, (long long)var);
+                continue;
+            }
+
+            if (!out.ends.empty())
+                normalize_clause(out.vars, clause_start);
+            out.ends.push_back(out.vars.size());
+            clause_start = out.vars.size();
+        }
+        if (p < end)
+            p++;
+    }
+}
+
+// the weight of each pair of a clause of k variables
+static inline long double clause_weight(size_t k)
+{
+    return 1.0L / ((long double)k * ((long double)k - 1.0L) / 2.0L);
+}
+
+// adds the clique of each clause with a variable in [lo, hi) to the lists of
+// these variables, in the order (and with the weights) of add_edge() on the
+// pairs of the clauses: a variable gets the other ones of the clause in
+// increasing order (only the bigger ones if the graph is half stored)
+static void add_cliques(
+    GraphPlain& g,
+    const CnfChunk& chunk,
+    const size_t *first,
+    const size_t *last,
+    uint32_t lo,
+    uint32_t hi)
+{
+    for (const size_t *c = first; c != last; c++) {
+        const uint32_t *b = chunk.clause_begin(*c), *e = chunk.clause_end(*c);
+        size_t k = e - b;
+        if (k < 2)
+            continue;
+        long double weight = clause_weight(k);
+
+        for (const uint32_t *v = lower_bound(b, e, lo); v != e && *v < hi; v++) {
+            vector<pair<int, long double> >& l = g.links[*v];
+            for (const uint32_t *w = g.half ? v + 1 : b; w != e; w++) {
+                if (w != v)
+                    l.push_back(make_pair((int)*w, weight));
+            }
+        }
+    }
+}
+
+bool read_cnf_vig(
+    const char *filename,
+    unsigned nb_threads,
+    GraphPlain& g,
+    string& err,
+    bool as_hyperedges)
+{
+    MappedFile f;
+    if (!f.open(filename)) {
+        err = string("The file ") + filename + " does not exist";
+        return false;
+    }
+
+    if (nb_threads == 0)
+        nb_threads = max(1U, thread::hardware_concurrency());
+
+    vector<const char *> bounds;
+    split_lines(f.data, f.size, nb_threads, bounds);
+    size_t nb_chunks = bounds.size() - 1;
+
+    vector<CnfChunk> chunks(nb_chunks);
+    ThreadPool::shared().run_parallel(nb_chunks, [&](size_t i) {
+        parse_chunk(bounds[i], bounds[i + 1], chunks[i]);
+    });
+
+    long long max_var = 0;
+    for (size_t i = 0; i < nb_chunks; i++) {
+        if (chunks[i].err != NULL) {
+            long long line = 1 + count(f.data, chunks[i].err, '\n');
+            err = string("The file ") + filename + " is not a valid DIMACS CNF (line "
+                  + to_string(line) + ")";
+            return false;
+        }
+        max_var = max(max_var, chunks[i].max_var);
+    }
+    f.close();
+
+    // the clause crossing chunk boundaries is put together in pending, and
+    // becomes the head of the chunk where it ends. The last clause, without
+    // its terminating 0, is the head of an extra chunk
+    vector<uint32_t> pending;
+    for (size_t c = 0; c < nb_chunks; c++) {
+        CnfChunk& chunk = chunks[c];
+        if (chunk.ends.empty()) {
+            pending.insert(pending.end(), chunk.vars.begin(), chunk.vars.end());
+            vector<uint32_t>().swap(chunk.vars);
+            continue;
+        }
+
+        pending.insert(pending.end(), chunk.vars.begin(), chunk.vars.begin() + chunk.ends[0]);
+        normalize_clause(pending, 0);
+        chunk.head.swap(pending);
+        pending.assign(chunk.vars.begin() + chunk.ends.back(), chunk.vars.end());
+    }
+    chunks.push_back(CnfChunk());
+    normalize_clause(pending, 0);
+    chunks.back().head.swap(pending);
+    chunks.back().ends.push_back(0);
+    nb_chunks++;
+
+    g.grow(max_var + 1);
+
+    if (as_hyperedges) {
+        for (size_t c = 0; c < nb_chunks; c++) {
+            for (size_t i = 0; i < chunks[c].ends.size(); i++) {
+                const uint32_t *b = chunks[c].clause_begin(i), *e = chunks[c].clause_end(i);
+                if (e - b >= 2)
+                    g.add_hyperedge(b, e, clause_weight(e - b));
+            }
+        }
+        return true;
+    }
+
+    // the clauses of each chunk are bucketed by the ranges of variables they
+    // have (count, prefix sum, scatter): bucket t of chunk c is
+    // [bucket_start[c][t], bucket_start[c][t + 1]) in buckets[c], in file order
+    // then each thread adds the cliques to the lists of its range of variables
+    size_t nb_vars = (size_t)max_var + 1;
+    size_t nb_ranges = min((size_t)nb_threads, nb_vars);
+    vector<uint32_t> range_bounds(1, 0U);
+    for (size_t t = 1; t <= nb_ranges; t++)
+        range_bounds.push_back((uint32_t)((unsigned long long)nb_vars * t / nb_ranges));
+    auto range_of = [&](uint32_t var) {
+        return (size_t)((((unsigned long long)var + 1ULL) * nb_ranges - 1ULL) / nb_vars);
+    };
+
+    vector<vector<size_t> > buckets(nb_chunks);
+    vector<vector<size_t> > bucket_start(nb_chunks);
+    ThreadPool::shared().run_parallel(nb_chunks, [&](size_t c) {
+        const CnfChunk& chunk = chunks[c];
+        vector<size_t>& b = bucket_start[c];
+        b.assign(nb_ranges + 1, 0);
+        // the variables of a clause are sorted, so are their ranges
+        auto for_each_range = [&](size_t i, const function<void(size_t)>& add) {
+            size_t last = nb_ranges;
+            for (const uint32_t *v = chunk.clause_begin(i); v != chunk.clause_end(i); v++) {
+                size_t t = range_of(*v);
+                if (t != last)
+                    add(t);
+                last = t;
+            }
+        };
+        for (size_t i = 0; i < chunk.ends.size(); i++)
+            for_each_range(i, [&](size_t t) { b[t + 1]++; });
+        for (size_t t = 1; t <= nb_ranges; t++)
+            b[t] += b[t - 1];
+
+        buckets[c].resize(b[nb_ranges]);
+        vector<size_t> pos(b.begin(), b.end() - 1);
+        for (size_t i = 0; i < chunk.ends.size(); i++)
+            for_each_range(i, [&](size_t t) { buckets[c][pos[t]++] = i; });
+    });
+
+    ThreadPool::shared().run_parallel(nb_ranges, [&](size_t t) {
+        for (size_t c = 0; c < nb_chunks; c++) {
+            const size_t *b = buckets[c].data();
+            add_cliques(g, chunks[c], b + bucket_start[c][t], b + bucket_start[c][t + 1],
+                range_bounds[t], range_bounds[t + 1]);
+        }
+    });
+
+    return true;
+}
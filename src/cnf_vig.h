@@ -0,0 +1,55 @@
+// File: cnf_vig.h
+// -- DIMACS CNF to variable incidence graph header file
+//-----------------------------------------------------------------------------
+// Community detection
+// Copyright (C) 2020 Mate Soos
+//
+// This file is part of Louvain algorithm.
+//
+// Louvain algorithm is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Louvain algorithm is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Louvain algorithm.  If not, see <http://www.gnu.org/licenses/>.
+//-----------------------------------------------------------------------------
+// see README.txt for more details
+
+#ifndef LOUVAIN_CNFVIG_H
+#define LOUVAIN_CNFVIG_H
+
+#include <string>
+
+#include "graph_plain.h"
+
+// reads a DIMACS CNF file and adds its variable incidence graph (VIG) to g
+//
+// every variable is a node (numbered as in the file, node 0 stays isolated)
+// and a clause over k distinct variables adds 1/(k*(k-1)/2) to the weight of
+// each of its k*(k-1)/2 pairs. A variable repeated in a clause counts once.
+// The same pair usually comes from several clauses: g must then be cleaned
+// with WEIGHTED to sum them up
+//
+// with as_hyperedges, each clause is added as a hyperedge (with the same
+// weight) instead of the k*(k-1)/2 edges of its clique
+//
+// the file is memory mapped and its lines are parsed by nb_threads threads
+// (0 means one per hardware thread), clauses may span several lines. The
+// edges are then added by as many threads, each one on a range of variables
+// (the hyperedges are added by the calling thread)
+// returns false if the file cannot be read or is not a valid DIMACS CNF, err
+// then gets the message and g is unchanged
+bool read_cnf_vig(
+    const char *filename,
+    unsigned nb_threads,
+    GraphPlain& g,
+    string& err,
+    bool as_hyperedges = false);
+
+#endif // LOUVAIN_CNFVIG_H
@@ -36,6 +36,12 @@ using namespace std;
 
 CondorA::CondorA(GraphBin &gr, long double sum) : Quality(gr, "A-weighted Condorcet"), sum_se(sum)
 {
+    reset();
+}
+
+void CondorA::reset()
+{
+    size = g.nb_nodes;
     n2c.resize(size);
 
     in.resize(size);
@@ -56,14 +62,16 @@ long double CondorA::graph_weighting(GraphBin *g)
 {
     long double sum_se = 0.0L;
 
+    // the weights are rewritten below
+    g->detach();
+
     vector<long double> aux_weights;
 
     // foreach weight, change Aij to 4Aij/(d(i)+d(i)) - Aii/2d(i) - Ajj/2d(j)
+    // (a half stored graph keeps each edge once, so it counts twice in the sum)
     for (int u = 0; u < g->nb_nodes; u++) {
-        pair<vector<int>::iterator, vector<long double>::iterator> p = g->neighbors(u);
         int deg = g->nb_neighbors(u);
-        for (int i = 0; i < deg; i++) {
-            int neigh = *(p.first + i);
+        g->for_each_stored_neighbor(u, [&](int neigh, long double old_neigh) {
             long double neigh_w = 0.0L;
 
             long double aux_neigh_w = 0.0L; // to compute Âij = 2Aij / (d(i)+d(j))
@@ -71,12 +79,7 @@ long double CondorA::graph_weighting(GraphBin *g)
 
             long double deg_neigh = (long double)(g->nb_neighbors(neigh));
 
-            if ((g->weights).size() == 0)
-                aux_neigh_w = 2.0L / ((long double)deg + deg_neigh);
-            else {
-                long double old_neigh = (long double)*(p.second + i);
-                aux_neigh_w = 2.0L * old_neigh / ((long double)deg + deg_neigh);
-            }
+            aux_neigh_w = 2.0L * old_neigh / ((long double)deg + deg_neigh);
 
             tmp_neigh_w = (g->nb_selfloops(u)) / (2.0L * (long double)deg) +
                           (g->nb_selfloops(neigh)) / (2.0L * deg_neigh);
@@ -85,11 +88,12 @@ long double CondorA::graph_weighting(GraphBin *g)
             aux_weights.push_back(neigh_w);
 
             sum_se += tmp_neigh_w - aux_neigh_w;
-        }
+            if (g->half && neigh != u)
+                sum_se += tmp_neigh_w - aux_neigh_w;
+        });
     }
 
-    g->weights.clear();
-    g->weights = aux_weights;
+    g->set_weights(aux_weights);
 
     g->total_weight = 0.0L;
 
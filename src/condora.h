@@ -46,6 +46,8 @@ class CondorA : public Quality
     CondorA(GraphBin &gr, long double sum);
     ~CondorA();
 
+    void reset();
+
     // change the weight of each link ij in the graph, from Aij to 4Aij/(d(i)+d(j)) - Aii/2d(i) - Ajj/2d(j)
     // return the result of Sum [Aii/2d(i) + Ajj/2d(j) - 2Aij/(d(i)+d(j))]
     static long double graph_weighting(GraphBin *g);
@@ -36,6 +36,12 @@ using namespace std;
 
 DevInd::DevInd(GraphBin& gr) : Quality(gr, "Deviation to Indetermination")
 {
+    reset();
+}
+
+void DevInd::reset()
+{
+    size = g.nb_nodes;
     n2c.resize(size);
 
     in.resize(size);
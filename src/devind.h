@@ -46,6 +46,8 @@ class DevInd : public Quality
     DevInd(GraphBin& gr);
     ~DevInd();
 
+    void reset();
+
     inline void remove(int node, int comm, long double dnodecomm);
 
     inline void insert(int node, int comm, long double dnodecomm);
@@ -36,6 +36,12 @@ using namespace std;
 
 DevUni::DevUni(GraphBin& gr) : Quality(gr, "Deviation to Uniformity")
 {
+    reset();
+}
+
+void DevUni::reset()
+{
+    size = g.nb_nodes;
     n2c.resize(size);
 
     in.resize(size);
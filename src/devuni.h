@@ -46,6 +46,8 @@ class DevUni : public Quality
     DevUni(GraphBin& gr);
     ~DevUni();
 
+    void reset();
+
     inline void remove(int node, int comm, long double dnodecomm);
 
     inline void insert(int node, int comm, long double dnodecomm);
@@ -35,8 +35,15 @@
 using namespace std;
 
 DP::DP(GraphBin &gr, long double sum, long double max_w)
-    : Quality(gr, "Profile Difference"), kappa(size), sum_sq(sum), max(max_w)
+    : Quality(gr, "Profile Difference"), sum_sq(sum), max(max_w)
 {
+    reset();
+}
+
+void DP::reset()
+{
+    size = g.nb_nodes;
+    kappa = size;
     n2c.resize(size);
 
     in.resize(size);
@@ -60,32 +67,28 @@ long double DP::graph_weighting(GraphBin *g)
 {
     long double sum_sq = 0.0L;
 
+    // the weights are rewritten below
+    g->detach();
+
     vector<long double> aux_weights;
 
     // foreach weight, change Aij to 2Aij / (d(i)+d(j))
+    // (a half stored graph keeps each edge once, so it counts twice in the sum)
     for (int u = 0; u < g->nb_nodes; u++) {
-        pair<vector<int>::iterator, vector<long double>::iterator> p = g->neighbors(u);
         int deg = g->nb_neighbors(u);
-        for (int i = 0; i < deg; i++) {
-            int neigh = *(p.first + i);
-            long double neigh_w = 0.0L;
-
-            if (g->weights.size() == 0)
-                neigh_w = 2.0L / ((long double)deg + (long double)(g->nb_neighbors(neigh)));
-            else {
-                long double old_neigh = (long double)*(p.second + i);
-                neigh_w =
-                    2.0L * old_neigh / ((long double)deg + (long double)(g->nb_neighbors(neigh)));
-            }
+        g->for_each_stored_neighbor(u, [&](int neigh, long double old_neigh) {
+            long double neigh_w =
+                2.0L * old_neigh / ((long double)deg + (long double)(g->nb_neighbors(neigh)));
 
             aux_weights.push_back(neigh_w);
 
             sum_sq += neigh_w * neigh_w;
-        }
+            if (g->half && neigh != u)
+                sum_sq += neigh_w * neigh_w;
+        });
     }
 
-    g->weights.clear();
-    g->weights = aux_weights;
+    g->set_weights(aux_weights);
 
     g->total_weight = 0.0L;
 
@@ -50,6 +50,8 @@ class DP : public Quality
     DP(GraphBin &gr, long double sum, long double max_w);
     ~DP();
 
+    void reset();
+
     // change the weight of each link ij in the graph, from Aij to 2Aij / (d(i)+d(j))
     // return the result of Sum Âij^2
     static long double graph_weighting(GraphBin *g);
@@ -0,0 +1,356 @@
+// File: edge_list.cpp
+// -- parallel text edge list reader source file
+//-----------------------------------------------------------------------------
+// Community detection
+// Copyright (C) 2020 Mate Soos
+//
+// This file is part of Louvain algorithm.
+//
+// Louvain algorithm is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Louvain algorithm is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Louvain algorithm.  If not, see <http://www.gnu.org/licenses/>.
+//-----------------------------------------------------------------------------
+// see README.txt for more details
+
+#include "edge_list.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "mapped_file.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+// below this size, a chunk is not worth a thread
+#define MIN_CHUNK_SIZE (1ULL << 20)
+
+// above this size, a chunk could hold 2^32 edges (a line takes at least 4
+// bytes), the file is split in more chunks than threads
+#define MAX_CHUNK_SIZE (1ULL << 33)
+
+// (mantissa * 10^exp) is computed with a single, correctly rounded operation
+// when both operands are exact, which gives the same result as strtold
+#if LDBL_MANT_DIG >= 64
+#define EXACT_DIGITS 19
+#define EXACT_POW10 27
+#else
+#define EXACT_DIGITS 15
+#define EXACT_POW10 22
+#endif
+
+static const long double pow10_table[28] = {
+    1e0L,  1e1L,  1e2L,  1e3L,  1e4L,  1e5L,  1e6L,  1e7L,  1e8L,  1e9L,
+    1e10L, 1e11L, 1e12L, 1e13L, 1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L,
+    1e20L, 1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L};
+
+static inline bool is_blank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool is_digit(char c)
+{
+    return (unsigned char)(c - '0') < 10;
+}
+
+static inline bool at_token_end(const char *p, const char *end)
+{
+    return p == end || is_blank(*p) || *p == '\n';
+}
+
+static inline const char *skip_blanks(const char *p, const char *end)
+{
+    while (p < end && is_blank(*p))
+        p++;
+    return p;
+}
+
+static inline const char *skip_line(const char *p, const char *end)
+{
+    const char *nl = (const char *)memchr(p, '\n', end - p);
+    return nl ? nl + 1 : end;
+}
+
+bool scan_node(const char *&p, const char *end, uint32_t& out)
+{
+    const char *q = p;
+    if (q < end && *q == '+')
+        q++;
+
+    const char *start = q;
+    uint64_t v = 0ULL;
+    while (q < end && is_digit(*q)) {
+        v = v * 10ULL + (uint64_t)(*q - '0');
+        if (v > 0xffffffffULL)
+            return false;
+        q++;
+    }
+    if (q == start || !at_token_end(q, end))
+        return false;
+
+    out = (uint32_t)v;
+    p = q;
+    return true;
+}
+
+// slow path for everything the scanner does not handle exactly
+// (more than EXACT_DIGITS significant digits, huge exponents, inf, nan...)
+static bool scan_weight_strtold(const char *&p, const char *end, long double& out)
+{
+    const char *q = p;
+    while (!at_token_end(q, end))
+        q++;
+
+    char buf[128];
+    size_t len = q - p;
+    if (len == 0 || len >= sizeof(buf))
+        return false;
+    memcpy(buf, p, len);
+    buf[len] = 0;
+
+    char *endptr;
+    out = strtold(buf, &endptr);
+    if (endptr != buf + len)
+        return false;
+
+    p = q;
+    return true;
+}
+
+bool scan_weight(const char *&p, const char *end, long double& out)
+{
+    const char *q = p;
+    bool neg = false;
+    if (q < end && (*q == '+' || *q == '-')) {
+        neg = (*q == '-');
+        q++;
+    }
+
+    uint64_t mant = 0ULL;
+    int digits = 0;
+    int exp10 = 0;
+    bool any = false;
+
+    for (; q < end && is_digit(*q); q++) {
+        any = true;
+        if (mant == 0ULL && *q == '0')
+            continue;
+        mant = mant * 10ULL + (uint64_t)(*q - '0');
+        if (++digits > EXACT_DIGITS)
+            return scan_weight_strtold(p, end, out);
+    }
+
+    if (q < end && *q == '.') {
+        for (q++; q < end && is_digit(*q); q++) {
+            any = true;
+            exp10--;
+            if (mant == 0ULL && *q == '0')
+                continue;
+            mant = mant * 10ULL + (uint64_t)(*q - '0');
+            if (++digits > EXACT_DIGITS)
+                return scan_weight_strtold(p, end, out);
+        }
+    }
+
+    if (!any)
+        return scan_weight_strtold(p, end, out);
+
+    if (q < end && (*q == 'e' || *q == 'E')) {
+        q++;
+        bool eneg = false;
+        if (q < end && (*q == '+' || *q == '-')) {
+            eneg = (*q == '-');
+            q++;
+        }
+        if (q == end || !is_digit(*q))
+            return false;
+        int e = 0;
+        for (; q < end && is_digit(*q); q++) {
+            if (e > 100000)
+                return scan_weight_strtold(p, end, out);
+            e = e * 10 + (*q - '0');
+        }
+        exp10 += eneg ? -e : e;
+    }
+
+    if (!at_token_end(q, end))
+        return false;
+
+    if (exp10 < -EXACT_POW10 || exp10 > EXACT_POW10)
+        return scan_weight_strtold(p, end, out);
+
+    long double r = (long double)mant;
+    if (exp10 < 0)
+        r /= pow10_table[-exp10];
+    else
+        r *= pow10_table[exp10];
+
+    out = neg ? -r : r;
+    p = q;
+    return true;
+}
+
+void split_lines(const char *data, size_t size, unsigned nb_threads, vector<const char *>& bounds)
+{
+    if (nb_threads == 0)
+        nb_threads = max(1U, thread::hardware_concurrency());
+
+    size_t nb_chunks = min((size_t)nb_threads, (size_t)(size / MIN_CHUNK_SIZE) + 1);
+    bounds.resize(nb_chunks + 1);
+    const char *end = data + size;
+    bounds[0] = data;
+    for (size_t i = 1; i < nb_chunks; i++) {
+        const char *b = data + size / nb_chunks * i;
+        bounds[i] = max(bounds[i - 1], b == data ? b : skip_line(b - 1, end));
+    }
+    bounds[nb_chunks] = end;
+}
+
+// parses the lines of [p, end) into out
+// return NULL on success, the start of the first malformed line otherwise
+static const char *parse_chunk(
+    const char *p,
+    const char *end,
+    int type,
+    vector<PlainEdge>& out,
+    long long& max_node)
+{
+    while (p < end) {
+        const char *line = p;
+        p = skip_blanks(p, end);
+        if (p == end)
+            break;
+        if (*p == '\n') {
+            p++;
+            continue;
+        }
+        if (*p == '#' || *p == '%') {
+            p = skip_line(p, end);
+            continue;
+        }
+
+        PlainEdge e;
+        e.weight = 1.0L;
+
+        if (!scan_node(p, end, e.src))
+            return line;
+        p = skip_blanks(p, end);
+        if (!scan_node(p, end, e.dest))
+            return line;
+        if (type == WEIGHTED) {
+            p = skip_blanks(p, end);
+            if (!scan_weight(p, end, e.weight))
+                return line;
+        }
+
+        out.push_back(e);
+        max_node = max(max_node, (long long)max(e.src, e.dest));
+
+        p = skip_line(p, end);
+    }
+    return NULL;
+}
+
+void read_edge_list(
+    const char *filename,
+    int type,
+    unsigned nb_threads,
+    vector<vector<PlainEdge> >& out_chunks,
+    long long& max_node)
+{
+    MappedFile f;
+    if (!f.open(filename)) {
+        cerr << "The file " << filename << " does not exist" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    if (nb_threads == 0)
+        nb_threads = max(1U, thread::hardware_concurrency());
+    nb_threads = (unsigned)max((unsigned long long)nb_threads, f.size / MAX_CHUNK_SIZE + 1ULL);
+
+    vector<const char *> bounds;
+    split_lines(f.data, f.size, nb_threads, bounds);
+    size_t nb_chunks = bounds.size() - 1;
+
+    out_chunks.clear();
+    out_chunks.resize(nb_chunks);
+    vector<long long> chunk_max(nb_chunks, -1);
+    vector<const char *> chunk_err(nb_chunks, (const char *)NULL);
+
+    ThreadPool::shared().run_parallel(nb_chunks, [&](size_t i) {
+        chunk_err[i] = parse_chunk(bounds[i], bounds[i + 1], type, out_chunks[i], chunk_max[i]);
+    });
+
+    max_node = -1;
+    for (size_t i = 0; i < nb_chunks; i++) {
+        if (chunk_err[i] != NULL) {
+            long long line = 1 + count(f.data, chunk_err[i], '\n');
+            cerr << "The file " << filename << " is not a valid edge list (line " << line << ")"
+                 << endl;
+            exit(EXIT_FAILURE);
+        }
+        max_node = max(max_node, chunk_max[i]);
+    }
+}
+
+void read_edge_list_blocks(
+    const char *filename,
+    int type,
+    size_t block_size,
+    unsigned nb_threads,
+    const function<void(vector<PlainEdge>&)>& f)
+{
+    MappedFile file;
+    if (!file.open(filename)) {
+        cerr << "The file " << filename << " does not exist" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    if (nb_threads == 0)
+        nb_threads = max(1U, thread::hardware_concurrency());
+
+    const char *p = file.data;
+    const char *end = file.data + file.size;
+    vector<const char *> bounds;
+    vector<vector<PlainEdge> > edges(nb_threads);
+    vector<long long> block_max(nb_threads, -1);
+    vector<const char *> block_err(nb_threads, (const char *)NULL);
+    while (p < end) {
+        // cut the next round of at most nb_threads blocks
+        bounds.assign(1, p);
+        while (p < end && bounds.size() <= nb_threads) {
+            p = ((size_t)(end - p) > block_size) ? skip_line(p + block_size - 1, end) : end;
+            bounds.push_back(p);
+        }
+        size_t nb_blocks = bounds.size() - 1;
+
+        ThreadPool::shared().run_parallel(nb_blocks, [&](size_t i) {
+            edges[i].clear();
+            block_err[i] = parse_chunk(bounds[i], bounds[i + 1], type, edges[i], block_max[i]);
+        });
+
+        for (size_t i = 0; i < nb_blocks; i++) {
+            if (block_err[i] != NULL) {
+                long long line = 1 + count(file.data, block_err[i], '\n');
+                cerr << "The file " << filename << " is not a valid edge list (line " << line << ")"
+                     << endl;
+                exit(EXIT_FAILURE);
+            }
+            f(edges[i]);
+        }
+    }
+}
@@ -0,0 +1,82 @@
+// File: edge_list.h
+// -- parallel text edge list reader header file
+//-----------------------------------------------------------------------------
+// Community detection
+// Copyright (C) 2020 Mate Soos
+//
+// This file is part of Louvain algorithm.
+//
+// Louvain algorithm is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Louvain algorithm is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Louvain algorithm.  If not, see <http://www.gnu.org/licenses/>.
+//-----------------------------------------------------------------------------
+// see README.txt for more details
+
+#ifndef LOUVAIN_EDGELIST_H
+#define LOUVAIN_EDGELIST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#define WEIGHTED 0
+#define UNWEIGHTED 1
+
+using namespace std;
+
+struct PlainEdge {
+    uint32_t src;
+    uint32_t dest;
+    long double weight;
+};
+
+// text file format is one edge per line:
+//    src dest          (UNWEIGHTED)
+//    src dest weight   (WEIGHTED)
+// separated by spaces or tabs; empty lines and lines starting with '#' or '%'
+// are skipped, anything after the last expected column is ignored
+//
+// the file is memory mapped and split into newline aligned chunks that are
+// parsed concurrently by nb_threads threads (0 means one per hardware thread)
+// edges are returned per chunk, in file order, a chunk holds less than 2^32
+// edges (there are more chunks than threads for a very large file)
+// max_node is set to the largest node id seen, or -1 if there is no edge
+void read_edge_list(
+    const char *filename,
+    int type,
+    unsigned nb_threads,
+    vector<vector<PlainEdge> >& out_chunks,
+    long long& max_node);
+
+// same, without holding the whole edge list: the file is parsed by blocks of
+// about block_size bytes (cut at a newline), nb_threads blocks at a time
+// (0 means one per hardware thread), f is called on the edges of each block
+// in turn, in file order, from the calling thread
+void read_edge_list_blocks(
+    const char *filename,
+    int type,
+    size_t block_size,
+    unsigned nb_threads,
+    const function<void(vector<PlainEdge>&)>& f);
+
+// splits [data, data + size) in newline aligned chunks, at most nb_threads
+// (0 means one per hardware thread) and none much smaller than 1MB
+// chunk i is [bounds[i], bounds[i + 1])
+void split_lines(const char *data, size_t size, unsigned nb_threads, vector<const char *>& bounds);
+
+// parses a single node id / weight token starting at p, moves p past it
+// return false if the text at p is not a valid token
+bool scan_node(const char *&p, const char *end, uint32_t& out);
+bool scan_weight(const char *&p, const char *end, long double& out);
+
+#endif // LOUVAIN_EDGELIST_H
@@ -36,6 +36,12 @@ using namespace std;
 
 Goldberg::Goldberg(GraphBin& gr, long double max_w) : Quality(gr, "Goldberg Density"), max(max_w)
 {
+    reset();
+}
+
+void Goldberg::reset()
+{
+    size = g.nb_nodes;
     n2c.resize(size);
 
     in.resize(size);
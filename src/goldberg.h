@@ -48,6 +48,8 @@ class Goldberg : public Quality
     Goldberg(GraphBin& gr, long double max_w);
     ~Goldberg();
 
+    void reset();
+
     inline void remove(int node, int comm, long double dnodecomm);
 
     inline void insert(int node, int comm, long double dnodecomm);
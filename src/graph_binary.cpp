@@ -31,8 +31,28 @@
 // see README.txt for more details
 
 #include "graph_binary.h"
+#include <cmath>
+#include <cstring>
 #include <fstream>
 
+// 64 bits FNV-1a, h is the hash of the data before (or FNV_OFFSET)
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static uint64_t fnv1a(uint64_t h, const char *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        h ^= (unsigned char)data[i];
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+static uint64_t align_pos(uint64_t pos)
+{
+    return (pos + GRAPH_ALIGN - 1) / GRAPH_ALIGN * GRAPH_ALIGN;
+}
+
 GraphBin::GraphBin()
 {
     nb_nodes = 0;
@@ -40,6 +60,21 @@ GraphBin::GraphBin()
 
     total_weight = 0.0L;
     sum_nodes_w = 0;
+
+    half = false;
+    nb_hyper = 0;
+    compressed = false;
+    weight_storage = WEIGHTS_LONG_DOUBLE;
+    weight_scale = 1.0L;
+
+    offset_width = 4;
+    offsets32.v.assign(1, 0U);
+    offsets32.own();
+
+    mapped_links = NULL;
+    mapped_weights = NULL;
+    mapped_w_degrees = NULL;
+    mapped_qweights = NULL;
 }
 
 
@@ -47,7 +82,12 @@ GraphBin::GraphBin(
     vector<unsigned long long>& out_deg_seq,
     vector<int>& out_links,
     vector<long double>& out_w,
-    int type)
+    int type,
+    bool _half) :
+    half(_half), nb_hyper(0),
+    mapped_links(NULL), mapped_weights(NULL), mapped_w_degrees(NULL),
+    compressed(false), weight_storage(WEIGHTS_LONG_DOUBLE), weight_scale(1.0L),
+    mapped_qweights(NULL)
 {
 
     // Read number of nodes on 4 bytes
@@ -55,25 +95,25 @@ GraphBin::GraphBin(
 
     // Read cumulative degree sequence: 8 bytes for each node
     // cum_degree[0]=degree(0); cum_degree[1]=degree(0)+degree(1), etc.
-    degrees = out_deg_seq;
+    set_offsets(out_deg_seq);
 
     // Read links: 4 bytes for each link (each link is counted twice)
-    if (nb_nodes == 0) {
-        nb_links = 0;
-    } else {
-        nb_links = degrees[nb_nodes - 1];
-    }
-    links.resize(nb_links);
-    links = out_links;
+    nb_links = offset(nb_nodes);
+    assert(out_links.size() == nb_links);
+    links.swap(out_links);
 
     // IF WEIGHTED, read weights: 10 bytes for each link (each link is counted twice)
     weights.resize(0);
     total_weight = 0.0L;
     if (type == WEIGHTED) {
-
-        weights.resize(nb_links);
         assert(out_w.size() == nb_links);
-        weights = out_w;
+        weights.swap(out_w);
+    }
+
+    if (half) {
+        build_reverse_index();
+        for (int i = 0; i < nb_nodes; i++)
+            nb_links += (unsigned long long)nb_rev_neighbors(i);
     }
 
     // Compute total weight
@@ -86,6 +126,26 @@ GraphBin::GraphBin(
 
 GraphBin::GraphBin(const char *filename, const char *filename_w, int type)
 {
+    half = false;
+    nb_hyper = 0;
+    compressed = false;
+    weight_storage = WEIGHTS_LONG_DOUBLE;
+    weight_scale = 1.0L;
+
+    offset_width = 4;
+    offsets32.v.assign(1, 0U);
+    offsets32.own();
+
+    mapped_links = NULL;
+    mapped_weights = NULL;
+    mapped_w_degrees = NULL;
+    mapped_qweights = NULL;
+
+    if (is_graph_v2(filename)) {
+        map_v2(filename);
+        return;
+    }
+
     ifstream finput;
     finput.open(filename, fstream::in | fstream::binary);
     if (finput.is_open() != true) {
@@ -102,11 +162,12 @@ GraphBin::GraphBin(const char *filename, const char *filename_w, int type)
 
     // Read cumulative degree sequence: 8 bytes for each node
     // cum_degree[0]=degree(0); cum_degree[1]=degree(0)+degree(1), etc.
-    degrees.resize(nb_nodes);
-    finput.read((char *)&degrees[0], nb_nodes * sizeof(unsigned long long));
+    vector<unsigned long long> deg_seq(nb_nodes);
+    finput.read((char *)&deg_seq[0], nb_nodes * sizeof(unsigned long long));
+    set_offsets(deg_seq);
 
     // Read links: 4 bytes for each link (each link is counted twice)
-    nb_links = degrees[nb_nodes - 1];
+    nb_links = offset(nb_nodes);
     links.resize(nb_links);
     finput.read((char *)(&links[0]), nb_links * sizeof(int));
 
@@ -138,12 +199,546 @@ GraphBin::GraphBin(const char *filename, const char *filename_w, int type)
     sum_nodes_w = nb_nodes;
 }
 
+bool is_graph_v2(const char *filename)
+{
+    ifstream finput;
+    finput.open(filename, fstream::in | fstream::binary);
+
+    char magic[8];
+    finput.read(magic, sizeof(magic));
+    return finput && memcmp(magic, GRAPH_MAGIC, sizeof(magic)) == 0;
+}
+
+void GraphBin::map_v2(const char *filename)
+{
+    mapping.reset(new MappedFile);
+    if (!mapping->open(filename, false)) {
+        cerr << "The file " << filename << " does not exist" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    const char *data = mapping->data;
+    uint64_t size = mapping->size;
+    GraphFileHeader h;
+    if (size < sizeof(h)) {
+        cerr << "The file " << filename << " is not a valid graph" << endl;
+        exit(EXIT_FAILURE);
+    }
+    memcpy(&h, data, sizeof(h));
+
+    if (h.byte_order != GRAPH_BYTE_ORDER) {
+        cerr << "The file " << filename << " was written on a machine with another byte order"
+             << endl;
+        exit(EXIT_FAILURE);
+    }
+    // version 2 only differs by its offsets (cumulative degrees on 8 bytes)
+    bool cumulative = (h.version == 2);
+    if ((h.version != GRAPH_VERSION && !cumulative) || h.header_size != sizeof(h) ||
+        (h.offset_width != 4 && h.offset_width != 8) || (cumulative && h.offset_width != 8) ||
+        h.weight_type > GRAPH_WEIGHT_U8) {
+        cerr << "The file " << filename << " has an unsupported format (version " << h.version
+             << ")" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    // every section must be aligned and lie within the file
+    uint64_t len_w = 0ULL;
+    if (h.weight_type == GRAPH_WEIGHT_F64)
+        len_w = h.nb_links * sizeof(double);
+    else if (h.weight_type == GRAPH_WEIGHT_F32)
+        len_w = h.nb_links * sizeof(float);
+    else if (h.weight_type == GRAPH_WEIGHT_U16)
+        len_w = sizeof(double) + h.nb_links * sizeof(uint16_t);
+    else if (h.weight_type == GRAPH_WEIGHT_U8)
+        len_w = sizeof(double) + h.nb_links * sizeof(uint8_t);
+    uint64_t pos[5] = {h.offsets_pos, h.links_pos, h.weights_pos, h.nodes_w_pos, h.degrees_pos};
+    uint64_t nb_offsets = cumulative ? h.nb_nodes : h.nb_nodes + 1;
+    uint64_t len[5] = {nb_offsets * h.offset_width, h.nb_links * sizeof(int), len_w,
+        h.nb_nodes * sizeof(int), h.nb_nodes * sizeof(double)};
+    bool valid = (h.file_size == size && h.nb_nodes <= (uint64_t)INT32_MAX);
+    for (int i = 0; i < 5 && valid; i++) {
+        if (len[i] != 0 && (pos[i] % GRAPH_ALIGN != 0 || pos[i] > size || len[i] > size - pos[i]))
+            valid = false;
+    }
+    if (!valid) {
+        cerr << "The file " << filename << " is not a valid graph" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    nb_nodes = (int)h.nb_nodes;
+    nb_links = h.nb_links;
+    total_weight = (long double)h.total_weight;
+
+    offset_width = h.offset_width;
+    if (cumulative) {
+        const unsigned long long *deg = (const unsigned long long *)(data + h.offsets_pos);
+        offsets64.v.assign(1, 0ULL);
+        offsets64.v.insert(offsets64.v.end(), deg, deg + nb_nodes);
+        offsets64.own();
+    } else if (offset_width == 4) {
+        offsets32.map((const uint32_t *)(data + h.offsets_pos));
+    } else {
+        offsets64.map((const unsigned long long *)(data + h.offsets_pos));
+    }
+    mapped_links = (const int *)(data + h.links_pos);
+    if (h.weight_type == GRAPH_WEIGHT_F64) {
+        mapped_weights = (const double *)(data + h.weights_pos);
+    } else if (h.weight_type == GRAPH_WEIGHT_F32) {
+        weight_storage = WEIGHTS_F32;
+        mapped_qweights = (const unsigned char *)(data + h.weights_pos);
+    } else if (h.weight_type == GRAPH_WEIGHT_U16 || h.weight_type == GRAPH_WEIGHT_U8) {
+        double scale;
+        memcpy(&scale, data + h.weights_pos, sizeof(scale));
+        weight_storage = (h.weight_type == GRAPH_WEIGHT_U16) ? WEIGHTS_U16 : WEIGHTS_U8;
+        weight_scale = (long double)scale;
+        mapped_qweights = (const unsigned char *)(data + h.weights_pos + sizeof(double));
+    }
+    mapped_w_degrees = (const double *)(data + h.degrees_pos);
+
+    if (offset(0) != 0ULL || offset(nb_nodes) != nb_links) {
+        cerr << "The file " << filename << " is not a valid graph" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    const int *w = (const int *)(data + h.nodes_w_pos);
+    nodes_w.assign(w, w + nb_nodes);
+    sum_nodes_w = (int)h.sum_nodes_w;
+}
+
+bool GraphBin::check_checksum()
+{
+    if (!mapping)
+        return true;
+
+    GraphFileHeader h;
+    memcpy(&h, mapping->data, sizeof(h));
+    return fnv1a(FNV_OFFSET, mapping->data + sizeof(h), mapping->size - sizeof(h)) == h.checksum;
+}
+
+void GraphBin::detach()
+{
+    if (!mapping)
+        return;
+
+    if (offset_width == 4 && !offsets32.owned()) {
+        offsets32.v.assign(offsets32.data, offsets32.data + nb_nodes + 1);
+        offsets32.own();
+    }
+    if (offset_width == 8 && !offsets64.owned()) {
+        offsets64.v.assign(offsets64.data, offsets64.data + nb_nodes + 1);
+        offsets64.own();
+    }
+    links.assign(mapped_links, mapped_links + offset(nb_nodes));
+    if (mapped_weights != NULL)
+        weights.assign(mapped_weights, mapped_weights + links.size());
+    if (mapped_qweights != NULL) {
+        size_t size = (weight_storage == WEIGHTS_F32) ? sizeof(float)
+                      : (weight_storage == WEIGHTS_U16) ? sizeof(uint16_t) : sizeof(uint8_t);
+        qweights.assign(mapped_qweights, mapped_qweights + links.size() * size);
+    }
+
+    mapped_links = NULL;
+    mapped_weights = NULL;
+    mapped_w_degrees = NULL;
+    mapped_qweights = NULL;
+    mapping.reset();
+}
+
+void GraphBin::compress_links()
+{
+    assert(!half);
+    if (compressed)
+        return;
+    detach();
+
+    // the weights follow the links when sorting
+    int storage = weight_storage;
+    quantize_weights(WEIGHTS_LONG_DOUBLE);
+
+    clink_offsets.assign(nb_nodes + 1, 0ULL);
+    clinks.clear();
+
+    vector<pair<int, long double> > v;
+    vector<unsigned char> buf;
+    for (int u = 0; u < nb_nodes; u++) {
+        unsigned long long b = offset(u);
+        unsigned long long e = offset(u + 1);
+
+        if (!is_sorted(links.begin() + b, links.begin() + e)) {
+            v.clear();
+            for (unsigned long long i = b; i < e; i++)
+                v.push_back(make_pair(links[i], (weights.size() != 0) ? weights[i] : 1.0L));
+            sort(v.begin(), v.end());
+            for (unsigned long long i = b; i < e; i++) {
+                links[i] = v[i - b].first;
+                if (weights.size() != 0)
+                    weights[i] = v[i - b].second;
+            }
+        }
+
+        buf.resize(svb_max_size(e - b));
+        unsigned char *end =
+            svb_encode((const uint32_t *)links.data() + b, (uint32_t)(e - b), 0, buf.data());
+        clinks.insert(clinks.end(), buf.data(), end);
+        clink_offsets[u + 1] = clinks.size();
+    }
+    clinks.resize(clinks.size() + SVB_PADDING, 0);
+    clinks.shrink_to_fit();
+
+    vector<int>().swap(links);
+    compressed = true;
+
+    quantize_weights(storage);
+}
+
+void GraphBin::uncompress_links()
+{
+    if (!compressed)
+        return;
+
+    vector<int> aux_links;
+    aux_links.reserve(offset(nb_nodes));
+    for (int u = 0; u < nb_nodes; u++)
+        for_each_stored_neighbor(u, [&](int neigh, long double) { aux_links.push_back(neigh); });
+
+    links.swap(aux_links);
+    vector<unsigned long long>().swap(clink_offsets);
+    vector<unsigned char>().swap(clinks);
+    compressed = false;
+}
+
+void GraphBin::quantize_weights(int storage)
+{
+    if (!has_weights() || storage == weight_storage)
+        return;
+    detach();
+
+    unsigned long long nb_w = offset(nb_nodes);
+    vector<long double> w(nb_w);
+    for (unsigned long long i = 0; i < nb_w; i++)
+        w[i] = weight(i);
+
+    if ((storage == WEIGHTS_U16 || storage == WEIGHTS_U8) && nb_w != 0ULL &&
+        *min_element(w.begin(), w.end()) < 0.0L)
+        storage = WEIGHTS_F32;
+
+    vector<long double>().swap(weights);
+    vector<unsigned char>().swap(qweights);
+    weight_storage = storage;
+    weight_scale = 1.0L;
+
+    if (storage == WEIGHTS_F32) {
+        qweights.resize(nb_w * sizeof(float));
+        float *q = (float *)qweights.data();
+        for (unsigned long long i = 0; i < nb_w; i++)
+            q[i] = (float)w[i];
+    } else if (storage == WEIGHTS_U16 || storage == WEIGHTS_U8) {
+        // the scale is a double, as in the single-file format, so that a
+        // graph read back from a file has exactly the same weights
+        long double max_q = (storage == WEIGHTS_U16) ? 65535.0L : 255.0L;
+        long double max_w = (nb_w == 0ULL) ? 0.0L : *max_element(w.begin(), w.end());
+        if (max_w > 0.0L)
+            weight_scale = (long double)(double)(max_w / max_q);
+
+        size_t size = (storage == WEIGHTS_U16) ? sizeof(uint16_t) : sizeof(uint8_t);
+        qweights.resize(nb_w * size);
+        for (unsigned long long i = 0; i < nb_w; i++) {
+            long double q = min(max_q, roundl(w[i] / weight_scale));
+            if (storage == WEIGHTS_U16)
+                ((uint16_t *)qweights.data())[i] = (uint16_t)q;
+            else
+                qweights[i] = (uint8_t)q;
+        }
+    } else {
+        weights.swap(w);
+    }
+
+    // the quality functions need the total of the weights now stored
+    total_weight = 0.0L;
+    for (int i = 0; i < nb_nodes; i++)
+        total_weight += weighted_degree(i);
+}
+
+void GraphBin::set_weights(vector<long double>& w)
+{
+    detach();
+
+    int storage = weight_storage;
+    vector<unsigned char>().swap(qweights);
+    weight_storage = WEIGHTS_LONG_DOUBLE;
+    weights.swap(w);
+    w.clear();
+    quantize_weights(storage);
+}
+
+void GraphBin::set_offsets(vector<unsigned long long>& deg_seq)
+{
+    // the array of the width used keeps its memory (see
+    // Louvain::partition2graph_binary())
+    if (deg_seq.empty() || deg_seq.back() <= (unsigned long long)UINT32_MAX) {
+        offsets64.map(NULL);
+        offset_width = 4;
+        offsets32.v.resize(deg_seq.size() + 1);
+        offsets32.v[0] = 0U;
+        for (size_t i = 0; i < deg_seq.size(); i++)
+            offsets32.v[i + 1] = (uint32_t)deg_seq[i];
+        offsets32.own();
+        deg_seq.clear();
+    } else {
+        offsets32.map(NULL);
+        offset_width = 8;
+        deg_seq.insert(deg_seq.begin(), 0ULL);
+        offsets64.v.swap(deg_seq);
+        offsets64.own();
+    }
+}
+
+GraphFileWriter::GraphFileWriter(
+    const char *outfile,
+    uint64_t nb_nodes,
+    uint64_t nb_links,
+    int weight_type,
+    double _scale) :
+    section(GRAPH_SECTION_HEADER), pos(0), hash(FNV_OFFSET), scale(_scale)
+{
+    out.open(outfile, fstream::out | fstream::binary);
+    if (out.is_open() != true) {
+        cerr << "The file " << outfile << " cannot be written" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, GRAPH_MAGIC, sizeof(h.magic));
+    h.version = GRAPH_VERSION;
+    h.byte_order = GRAPH_BYTE_ORDER;
+    h.header_size = sizeof(h);
+    h.weight_type = weight_type;
+    h.nb_nodes = nb_nodes;
+    h.nb_links = nb_links;
+    // 4 bytes offsets if they fit
+    h.offset_width = (nb_links <= (unsigned long long)UINT32_MAX) ? 4 : 8;
+    max_q = (weight_type == GRAPH_WEIGHT_U16) ? 65535.0L : 255.0L;
+
+    // the header is written last, once the checksum is known
+    out.write((char *)&h, sizeof(h));
+    pos = sizeof(h);
+    buf.reserve(1 << 20);
+}
+
+void GraphFileWriter::begin(int s)
+{
+    static const char zeros[GRAPH_ALIGN] = {0};
+
+    // the sections skipped are left empty
+    while (section < s) {
+        section++;
+        if (section == GRAPH_SECTION_WEIGHTS && h.weight_type == GRAPH_WEIGHT_NONE)
+            continue;
+
+        write(zeros, align_pos(pos) - pos);
+        switch (section) {
+            case GRAPH_SECTION_OFFSETS:
+                h.offsets_pos = pos;
+                break;
+            case GRAPH_SECTION_LINKS:
+                h.links_pos = pos;
+                break;
+            case GRAPH_SECTION_WEIGHTS:
+                h.weights_pos = pos;
+                if (h.weight_type == GRAPH_WEIGHT_U16 || h.weight_type == GRAPH_WEIGHT_U8)
+                    write(&scale, sizeof(scale));
+                break;
+            case GRAPH_SECTION_NODES_W:
+                h.nodes_w_pos = pos;
+                break;
+            case GRAPH_SECTION_DEGREES:
+                h.degrees_pos = pos;
+                break;
+        }
+    }
+}
+
+void GraphFileWriter::add_weight(long double w)
+{
+    if (section != GRAPH_SECTION_WEIGHTS)
+        begin(GRAPH_SECTION_WEIGHTS);
+
+    if (h.weight_type == GRAPH_WEIGHT_F32) {
+        float f = (float)w;
+        write(&f, sizeof(f));
+    } else if (h.weight_type == GRAPH_WEIGHT_U16 || h.weight_type == GRAPH_WEIGHT_U8) {
+        long double q = min(max_q, roundl(w / (long double)scale));
+        uint16_t q16 = (uint16_t)q;
+        uint8_t q8 = (uint8_t)q;
+        if (h.weight_type == GRAPH_WEIGHT_U16)
+            write(&q16, sizeof(q16));
+        else
+            write(&q8, sizeof(q8));
+    } else {
+        double d = (double)w;
+        write(&d, sizeof(d));
+    }
+}
+
+long double GraphFileWriter::stored_weight(long double w)
+{
+    if (h.weight_type == GRAPH_WEIGHT_F32)
+        return (long double)(float)w;
+    if (h.weight_type == GRAPH_WEIGHT_U16 || h.weight_type == GRAPH_WEIGHT_U8)
+        return (long double)scale * min(max_q, roundl(w / (long double)scale));
+    return (long double)(double)w;
+}
+
+void GraphFileWriter::flush()
+{
+    hash = fnv1a(hash, buf.data(), buf.size());
+    out.write(buf.data(), buf.size());
+    buf.clear();
+}
+
+void GraphFileWriter::close(long double total_weight, int64_t sum_nodes_w)
+{
+    begin(GRAPH_SECTION_DEGREES);
+    flush();
+
+    h.total_weight = (double)total_weight;
+    h.sum_nodes_w = sum_nodes_w;
+    h.file_size = pos;
+    h.checksum = hash;
+    out.seekp(0);
+    out.write((char *)&h, sizeof(h));
+    out.close();
+    if (!out) {
+        cerr << "The graph file cannot be written" << endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+void GraphBin::display_binary_v2(const char *outfile, int weight_type)
+{
+    // the file has no hyperedges, they would have to be expanded
+    assert(nb_hyper == 0);
+
+    // integer weights: keep the scale of the graph if it has the same storage,
+    // otherwise the biggest weight is written as the biggest integer
+    bool as_int = has_weights() && (weight_type == GRAPH_WEIGHT_U16 || weight_type == GRAPH_WEIGHT_U8);
+    long double max_q = (weight_type == GRAPH_WEIGHT_U16) ? 65535.0L : 255.0L;
+    double scale = 1.0;
+    if (as_int) {
+        long double min_w = 0.0L, max_w = 0.0L;
+        for (int node = 0; node < nb_nodes; node++) {
+            for_each_plain_neighbor(node, [&](int, long double w) {
+                min_w = min(min_w, w);
+                max_w = max(max_w, w);
+            });
+        }
+        if (min_w < 0.0L) {
+            cerr << "The graph has negative weights, they cannot be written as unsigned integers"
+                 << endl;
+            exit(EXIT_FAILURE);
+        }
+        if ((weight_type == GRAPH_WEIGHT_U16 && weight_storage == WEIGHTS_U16) ||
+            (weight_type == GRAPH_WEIGHT_U8 && weight_storage == WEIGHTS_U8))
+            scale = (double)weight_scale;
+        else if (max_w > 0.0L)
+            scale = (double)(max_w / max_q);
+    }
+
+    // a half stored graph has more links in the file
+    unsigned long long file_links = 0ULL;
+    for (int node = 0; node < nb_nodes; node++)
+        file_links += (unsigned long long)nb_neighbors(node);
+
+    GraphFileWriter out(
+        outfile, nb_nodes, file_links, has_weights() ? weight_type : GRAPH_WEIGHT_NONE, scale);
+
+    unsigned long long tot = 0ULL;
+    for (int node = 0; node <= nb_nodes; node++) {
+        out.add_offset(tot);
+        if (node < nb_nodes)
+            tot += (unsigned long long)nb_neighbors(node);
+    }
+
+    for (int node = 0; node < nb_nodes; node++)
+        for_each_plain_neighbor(node, [&](int neigh, long double) { out.add_link(neigh); });
+
+    // the degrees are those of the weights read back from the file
+    vector<long double> degrees(nb_nodes);
+    for (int node = 0; node < nb_nodes; node++) {
+        long double d = 0.0L;
+        if (!has_weights())
+            d += (long double)nb_neighbors(node);
+        else
+            for_each_plain_neighbor(node, [&](int, long double w) {
+                out.add_weight(w);
+                d += out.stored_weight(w);
+            });
+        degrees[node] = d;
+    }
+
+    for (int node = 0; node < nb_nodes; node++)
+        out.add_node_w(nodes_w[node]);
+
+    long double file_total = 0.0L;
+    for (int node = 0; node < nb_nodes; node++) {
+        out.add_degree(degrees[node]);
+        file_total += degrees[node];
+    }
+
+    out.close(file_total, sum_nodes_w);
+}
+
+void GraphBin::set_hyperedges(
+    vector<unsigned long long>& offsets,
+    vector<int>& nodes,
+    vector<long double>& w)
+{
+    assert(offsets.size() == w.size());
+
+    nb_hyper = w.size();
+    hyper_offsets.swap(offsets);
+    hyper_nodes.swap(nodes);
+    hyper_w.swap(w);
+
+    // node -> hyperedges incidence, by counting sort
+    node_hyper_offsets.assign(nb_nodes + 1, 0ULL);
+    for (unsigned long long i = 0; i < hyper_nodes.size(); i++)
+        node_hyper_offsets[hyper_nodes[i] + 1]++;
+    for (int i = 1; i <= nb_nodes; i++)
+        node_hyper_offsets[i] += node_hyper_offsets[i - 1];
+
+    node_hyper.resize(hyper_nodes.size());
+    hyper_degree.assign(nb_nodes, 0.0L);
+    vector<unsigned long long> pos(node_hyper_offsets.begin(), node_hyper_offsets.end() - 1);
+
+    for (int c = 0; c < nb_hyper; c++) {
+        unsigned long long k = hyper_offsets[c] - hyper_start(c);
+        for (unsigned long long i = hyper_start(c); i < hyper_offsets[c]; i++) {
+            int node = hyper_nodes[i];
+            assert(node >= 0 && node < nb_nodes);
+            node_hyper[pos[node]++] = c;
+            hyper_degree[node] += hyper_w[c] * (long double)(k - 1);
+        }
+        nb_links += k * (k - 1);
+    }
+
+    for (int i = 0; i < nb_nodes; i++)
+        total_weight += hyper_degree[i];
+}
+
 long double GraphBin::max_weight()
 {
     long double max = 1.0L;
 
-    if (weights.size() != 0)
+    if (mapped_weights != NULL && nb_links != 0ULL)
+        max = (long double)*max_element(mapped_weights, mapped_weights + nb_links);
+    else if (weights.size() != 0)
         max = *max_element(weights.begin(), weights.end());
+    else if (weight_storage != WEIGHTS_LONG_DOUBLE && offset(nb_nodes) != 0ULL) {
+        max = weight(0);
+        for (unsigned long long i = 1; i < offset(nb_nodes); i++)
+            max = std::max(max, weight(i));
+    }
 
     return max;
 }
@@ -157,10 +752,112 @@ void GraphBin::assign_weight(int node, int weight)
     sum_nodes_w += weight;
 }
 
+void GraphBin::build_reverse_index()
+{
+    assert(half);
+
+    // the stored neighbors must be sorted for mirrored_weight
+    for (int u = 0; u < nb_nodes; u++) {
+        unsigned long long b = offset(u);
+        unsigned long long e = offset(u + 1);
+        if (is_sorted(links.begin() + b, links.begin() + e))
+            continue;
+
+        vector<pair<int, long double> > v;
+        for (unsigned long long i = b; i < e; i++)
+            v.push_back(make_pair(links[i], (weights.size() != 0) ? weights[i] : 1.0L));
+        sort(v.begin(), v.end());
+        for (unsigned long long i = b; i < e; i++) {
+            links[i] = v[i - b].first;
+            if (weights.size() != 0)
+                weights[i] = v[i - b].second;
+        }
+    }
+
+    // first pass: number of neighbors < v and size of their gaps, for each v
+    // (last[v] is the last neighbor < v seen so far)
+    vector<int> last(nb_nodes, -1);
+    vector<uint32_t> nb(nb_nodes, 0);
+    vector<unsigned long long> pos(nb_nodes, 0ULL);
+    for (int u = 0; u < nb_nodes; u++) {
+        for (unsigned long long i = offset(u); i < offset(u + 1); i++) {
+            int v = links[i];
+            assert(v >= u);
+            if (v == u)
+                continue;
+            pos[v] += varint_size((last[v] == -1) ? (uint32_t)(v - u) : (uint32_t)(u - last[v]));
+            last[v] = u;
+            nb[v]++;
+        }
+    }
+
+    rev_offsets.assign(nb_nodes + 1, 0ULL);
+    unsigned long long tot = 0ULL;
+    for (int v = 0; v < nb_nodes; v++) {
+        unsigned long long size = varint_size(nb[v]) + pos[v];
+        pos[v] = tot + varint_size(nb[v]);
+        tot += size;
+        rev_offsets[v + 1] = tot;
+    }
+
+    // second pass: write the counts and the gaps
+    rev_links.resize(tot);
+    for (int v = 0; v < nb_nodes; v++) {
+        put_varint(&rev_links[rev_offsets[v]], nb[v]);
+        last[v] = -1;
+    }
+    for (int u = 0; u < nb_nodes; u++) {
+        for (unsigned long long i = offset(u); i < offset(u + 1); i++) {
+            int v = links[i];
+            if (v == u)
+                continue;
+            uint32_t gap = (last[v] == -1) ? (uint32_t)(v - u) : (uint32_t)(u - last[v]);
+            pos[v] = put_varint(&rev_links[pos[v]], gap) - &rev_links[0];
+            last[v] = u;
+        }
+    }
+}
+
 void GraphBin::add_selfloops()
 {
+    detach();
+    bool was_compressed = compressed;
+    uncompress_links();
+    int storage = weight_storage;
+    quantize_weights(WEIGHTS_LONG_DOUBLE);
+
+    if (half) {
+        // the selfloop goes first, to keep the stored neighbors sorted
+        vector<unsigned long long> aux_deg;
+        vector<int> aux_links;
+        vector<long double> aux_weights;
+
+        for (int u = 0; u < nb_nodes; u++) {
+            if (nb_selfloops(u) == 0.0L) {
+                aux_links.push_back(u);
+                if (weights.size() != 0)
+                    aux_weights.push_back(1.0L);
+                nb_links += 1ULL;
+            }
+            for_each_stored_neighbor(u, [&](int neigh, long double w) {
+                aux_links.push_back(neigh);
+                if (weights.size() != 0)
+                    aux_weights.push_back(w);
+            });
+            aux_deg.push_back(aux_links.size());
+        }
+
+        links.swap(aux_links);
+        set_offsets(aux_deg);
+        if (weights.size() != 0)
+            weights.swap(aux_weights);
+        quantize_weights(storage);
+        return;
+    }
+
     vector<unsigned long long> aux_deg;
     vector<int> aux_links;
+    vector<long double> aux_weights;
 
     unsigned long long sum_d = 0ULL;
 
@@ -171,12 +868,16 @@ void GraphBin::add_selfloops()
         for (int i = 0; i < deg; i++) {
             int neigh = *(p.first + i);
             aux_links.push_back(neigh);
+            if (weights.size() != 0)
+                aux_weights.push_back(*(p.second + i));
         }
 
         sum_d += (unsigned long long)deg;
 
         if (nb_selfloops(u) == 0.0L) {
             aux_links.push_back(u); // add a selfloop
+            if (weights.size() != 0)
+                aux_weights.push_back(1.0L);
             sum_d += 1ULL;
         }
 
@@ -184,24 +885,27 @@ void GraphBin::add_selfloops()
     }
 
     links = aux_links;
-    degrees = aux_deg;
+    set_offsets(aux_deg);
+    if (weights.size() != 0)
+        weights = aux_weights;
 
     nb_links += (unsigned long long)nb_nodes;
+
+    if (was_compressed)
+        compress_links();
+    quantize_weights(storage);
 }
 
 void GraphBin::display()
 {
     for (int node = 0; node < nb_nodes; node++) {
-        pair<vector<int>::iterator, vector<long double>::iterator> p = neighbors(node);
         cout << node << ":";
-        for (int i = 0; i < nb_neighbors(node); i++) {
-            if (true) {
-                if (weights.size() != 0)
-                    cout << " (" << *(p.first + i) << " " << *(p.second + i) << ")";
-                else
-                    cout << " " << *(p.first + i);
-            }
-        }
+        for_each_neighbor(node, [&](int neigh, long double w) {
+            if (has_weights())
+                cout << " (" << neigh << " " << w << ")";
+            else
+                cout << " " << neigh;
+        });
         cout << endl;
     }
 }
@@ -209,15 +913,14 @@ void GraphBin::display()
 void GraphBin::display_reverse()
 {
     for (int node = 0; node < nb_nodes; node++) {
-        pair<vector<int>::iterator, vector<long double>::iterator> p = neighbors(node);
-        for (int i = 0; i < nb_neighbors(node); i++) {
-            if (node > *(p.first + i)) {
-                if (weights.size() != 0)
-                    cout << *(p.first + i) << " " << node << " " << *(p.second + i) << endl;
+        for_each_neighbor(node, [&](int neigh, long double w) {
+            if (node > neigh) {
+                if (has_weights())
+                    cout << neigh << " " << node << " " << w << endl;
                 else
-                    cout << *(p.first + i) << " " << node << endl;
+                    cout << neigh << " " << node << endl;
             }
-        }
+        });
     }
 }
 
@@ -225,23 +928,15 @@ bool GraphBin::check_symmetry()
 {
     int error = 0;
     for (int node = 0; node < nb_nodes; node++) {
-        pair<vector<int>::iterator, vector<long double>::iterator> p = neighbors(node);
-        for (int i = 0; i < nb_neighbors(node); i++) {
-            int neigh = *(p.first + i);
-            long double weight = *(p.second + i);
-
-            pair<vector<int>::iterator, vector<long double>::iterator> p_neigh = neighbors(neigh);
-            for (int j = 0; j < nb_neighbors(neigh); j++) {
-                int neigh_neigh = *(p_neigh.first + j);
-                long double neigh_weight = *(p_neigh.second + j);
-
+        for_each_plain_neighbor(node, [&](int neigh, long double weight) {
+            for_each_plain_neighbor(neigh, [&](int neigh_neigh, long double neigh_weight) {
                 if (node == neigh_neigh && weight != neigh_weight) {
                     cout << node << " " << neigh << " " << weight << " " << neigh_weight << endl;
                     if (error++ == 10)
                         exit(0);
                 }
-            }
-        }
+            });
+        });
     }
     return (error == 0);
 }
@@ -252,6 +947,23 @@ void GraphBin::display_binary(const char *outfile)
     foutput.open(outfile, fstream::out | fstream::binary);
 
     foutput.write((char *)(&nb_nodes), sizeof(int));
-    foutput.write((char *)(&degrees[0]), sizeof(unsigned long long) * nb_nodes);
-    foutput.write((char *)(&links[0]), sizeof(int) * nb_links);
+
+    // the file format has 8 bytes cumulative degrees
+    unsigned long long tot = 0ULL;
+    for (int node = 0; node < nb_nodes; node++) {
+        tot += (unsigned long long)nb_neighbors(node);
+        foutput.write((char *)(&tot), sizeof(unsigned long long));
+    }
+
+    if (!half && !compressed) {
+        foutput.write((char *)links_data(), sizeof(int) * offset(nb_nodes));
+        return;
+    }
+
+    // the file format has no half (or compressed) storage: write both directions
+    for (int node = 0; node < nb_nodes; node++) {
+        for_each_plain_neighbor(node, [&](int neigh, long double) {
+            foutput.write((char *)(&neigh), sizeof(int));
+        });
+    }
 }
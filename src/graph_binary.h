@@ -34,16 +34,228 @@
 #define LOUVAIN_GRAPHBINARY_H
 
 #include <assert.h>
+#include <stdint.h>
 #include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <vector>
 
+#include "mapped_file.h"
+#include "stream_vbyte.h"
+
 #define WEIGHTED 0
 #define UNWEIGHTED 1
 
+// single-file binary graph format (version 2)
+// the file starts with a GraphFileHeader, followed by sections aligned on
+// GRAPH_ALIGN bytes, found at the given positions from the start of the file:
+//    offsets: nb_nodes + 1 offsets of the adjacency lists in links (the
+//       first one is 0), on offset_width bytes (4 or 8)
+//       version 2 files hold the cumulative degree of each node instead
+//       (without the first 0) on 8 bytes
+//    links: 4 bytes for each link (each link is counted twice)
+//    weights: for each link, depending on weight_type
+//       GRAPH_WEIGHT_F64: an IEEE double
+//       GRAPH_WEIGHT_F32: an IEEE float
+//       GRAPH_WEIGHT_U16, GRAPH_WEIGHT_U8: the section starts with the scale
+//       (an IEEE double), followed by an unsigned integer of 2 (1) bytes, the
+//       weight divided by the scale
+//    nodes_w: 4 bytes for the weight of each node
+//    degrees: weighted degree of each node, an IEEE double each
+// checksum is the 64 bits FNV-1a hash of everything after the header
+#define GRAPH_MAGIC "COMMLGR2"
+#define GRAPH_VERSION 3
+#define GRAPH_BYTE_ORDER 0x01020304U
+#define GRAPH_ALIGN 64
+#define GRAPH_WEIGHT_NONE 0
+#define GRAPH_WEIGHT_F64 1
+#define GRAPH_WEIGHT_F32 2
+#define GRAPH_WEIGHT_U16 3
+#define GRAPH_WEIGHT_U8 4
+
+// in-memory storage of the weights of the links (see GraphBin)
+#define WEIGHTS_LONG_DOUBLE 0
+#define WEIGHTS_F32 1
+#define WEIGHTS_U16 2
+#define WEIGHTS_U8 3
+
+// number of neighbors decoded at once from a compressed adjacency list
+#define DECODE_BLOCK 128
+
+struct GraphFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t header_size;
+    uint8_t offset_width;
+    uint8_t weight_type;
+    uint8_t reserved[2];
+    uint64_t nb_nodes;
+    uint64_t nb_links;
+    double total_weight;
+    int64_t sum_nodes_w;
+    uint64_t offsets_pos;
+    uint64_t links_pos;
+    uint64_t weights_pos;
+    uint64_t nodes_w_pos;
+    uint64_t degrees_pos;
+    uint64_t file_size;
+    uint64_t checksum;
+};
+
 using namespace std;
 
+// sections of a single-file graph, in file order (see GraphFileWriter)
+#define GRAPH_SECTION_HEADER 0
+#define GRAPH_SECTION_OFFSETS 1
+#define GRAPH_SECTION_LINKS 2
+#define GRAPH_SECTION_WEIGHTS 3
+#define GRAPH_SECTION_NODES_W 4
+#define GRAPH_SECTION_DEGREES 5
+
+// streams a graph in the single-file format, one section after the other:
+// the nb_nodes + 1 offsets, the links, the weights (of the given GRAPH_WEIGHT_
+// type, none for GRAPH_WEIGHT_NONE), the weights of the nodes and their
+// weighted degrees. Sections can be left empty. close() writes the header
+// integer weights are written as the nearest multiple of scale
+// the degrees and the total weight must be those of the stored weights
+class GraphFileWriter
+{
+   public:
+    GraphFileWriter(
+        const char *outfile,
+        uint64_t nb_nodes,
+        uint64_t nb_links,
+        int weight_type,
+        double scale = 1.0);
+
+    inline void add_offset(unsigned long long o);
+    inline void add_link(int neigh);
+    void add_weight(long double w);
+    // the value read back from the file for a weight w
+    long double stored_weight(long double w);
+    inline void add_node_w(int w);
+    inline void add_degree(long double d);
+
+    void close(long double total_weight, int64_t sum_nodes_w);
+
+   private:
+    GraphFileWriter(const GraphFileWriter &);
+    GraphFileWriter &operator=(const GraphFileWriter &);
+
+    ofstream out;
+    GraphFileHeader h;
+    int section;
+    uint64_t pos;
+    uint64_t hash;
+    vector<char> buf;
+    double scale;
+    long double max_q;
+
+    // pads to section s, after the ones in between
+    void begin(int s);
+    inline void write(const void *data, size_t size);
+    void flush();
+};
+
+inline void GraphFileWriter::write(const void *data, size_t size)
+{
+    if (buf.size() + size > buf.capacity())
+        flush();
+    buf.insert(buf.end(), (const char *)data, (const char *)data + size);
+    pos += size;
+}
+
+inline void GraphFileWriter::add_offset(unsigned long long o)
+{
+    if (section != GRAPH_SECTION_OFFSETS)
+        begin(GRAPH_SECTION_OFFSETS);
+    if (h.offset_width == 4) {
+        uint32_t o32 = (uint32_t)o;
+        write(&o32, sizeof(o32));
+    } else {
+        write(&o, sizeof(o));
+    }
+}
+
+inline void GraphFileWriter::add_link(int neigh)
+{
+    if (section != GRAPH_SECTION_LINKS)
+        begin(GRAPH_SECTION_LINKS);
+    write(&neigh, sizeof(neigh));
+}
+
+inline void GraphFileWriter::add_node_w(int w)
+{
+    if (section != GRAPH_SECTION_NODES_W)
+        begin(GRAPH_SECTION_NODES_W);
+    write(&w, sizeof(w));
+}
+
+inline void GraphFileWriter::add_degree(long double d)
+{
+    if (section != GRAPH_SECTION_DEGREES)
+        begin(GRAPH_SECTION_DEGREES);
+    double d64 = (double)d;
+    write(&d64, sizeof(d64));
+}
+
+// the offsets of the links of a graph: offset() reads data, which points
+// either to v or to a mapped file. It keeps pointing to v when the graph is
+// copied or moved
+template <class T>
+struct OffsetArray {
+    vector<T> v;
+    const T *data;
+
+    OffsetArray() : data(NULL)
+    {
+    }
+    OffsetArray(const OffsetArray& o) : v(o.v), data(o.owned() ? v.data() : o.data)
+    {
+    }
+    OffsetArray(OffsetArray&& o) : v(std::move(o.v)), data(o.data)
+    {
+        o.data = NULL;
+    }
+    OffsetArray& operator=(const OffsetArray& o)
+    {
+        if (this != &o) {
+            v = o.v;
+            data = o.owned() ? v.data() : o.data;
+        }
+        return *this;
+    }
+    OffsetArray& operator=(OffsetArray&& o)
+    {
+        if (this != &o) {
+            bool own = o.owned();
+            v = std::move(o.v);
+            data = own ? v.data() : o.data;
+            o.data = NULL;
+        }
+        return *this;
+    }
+
+    bool owned() const
+    {
+        return data == v.data();
+    }
+    // data follows v, to call once v is filled
+    void own()
+    {
+        data = v.data();
+    }
+    // data is the mapped array p, v is emptied
+    void map(const T *p)
+    {
+        vector<T>().swap(v);
+        data = p;
+    }
+};
+
 class GraphBin
 {
    public:
@@ -53,18 +265,81 @@ class GraphBin
     long double total_weight;
     int sum_nodes_w;
 
-    vector<unsigned long long> degrees;
+    // the links of node are links[offset(node) .. offset(node + 1)), there are
+    // nb_nodes + 1 offsets, starting at 0. They are stored on 4 bytes
+    // (offsets32) if there are less than 2^32 links, on 8 bytes (offsets64)
+    // otherwise, offset_width tells which one is used (see set_offsets). The
+    // array of a mapped graph is read in the file
+    int offset_width;
+    OffsetArray<uint32_t> offsets32;
+    OffsetArray<unsigned long long> offsets64;
     vector<int> links;
     vector<long double> weights;
 
     vector<int> nodes_w;
 
+    // half storage: offsets, links and weights keep every edge only once, at
+    // its smaller endpoint (so the stored neighbors of a node are >= node, sorted)
+    // the neighbors < node are found in a lightweight reverse index: for each
+    // node, their number and then the gaps between them, all varint encoded
+    // (those of node start at rev_offsets[node], nb_nodes + 1 offsets from 0)
+    // the weight of a reverse neighbor is looked up in the mirrored edge
+    bool half;
+    vector<unsigned long long> rev_offsets;
+    vector<unsigned char> rev_links;
+
+    // hyperedges: hyperedge c stands for the clique over its (distinct) nodes,
+    // with weight hyper_w[c] on each edge, without materializing it
+    // its nodes are hyper_nodes[hyper_start(c) .. hyper_offsets[c]) and the
+    // hyperedges of a node are listed in node_hyper (offsets in
+    // node_hyper_offsets, like rev_offsets). hyper_degree is the weighted degree
+    // they add to each node
+    int nb_hyper;
+    vector<unsigned long long> hyper_offsets;
+    vector<int> hyper_nodes;
+    vector<long double> hyper_w;
+    vector<unsigned long long> node_hyper_offsets;
+    vector<int> node_hyper;
+    vector<long double> hyper_degree;
+
+    // zero-copy view of a mapped single-file graph: the accessors read the
+    // arrays below instead of offsets, links and weights (nodes_w is copied)
+    // functions modifying the graph call detach() first
+    shared_ptr<MappedFile> mapping;
+    const int *mapped_links;
+    const double *mapped_weights;
+    const double *mapped_w_degrees;
+
+    // compressed storage: the (sorted) neighbors of each node are delta coded
+    // with stream vbyte in clinks, links is empty. clink_offsets are the
+    // offsets in bytes, like rev_offsets. weights stay as they are
+    // for_each_stored_neighbor decodes them by blocks of DECODE_BLOCK
+    bool compressed;
+    vector<unsigned long long> clink_offsets;
+    vector<unsigned char> clinks;
+
+    // quantized weights: unless weight_storage is WEIGHTS_LONG_DOUBLE, weights
+    // is empty and the weight of link i is found in qweights (or in the mapped
+    // file at mapped_qweights), as a float (WEIGHTS_F32), or as weight_scale
+    // times an unsigned integer of 2 bytes (WEIGHTS_U16) or 1 byte (WEIGHTS_U8)
+    // the accessors decode them on the fly, sums stay in long double
+    int weight_storage;
+    long double weight_scale;
+    vector<unsigned char> qweights;
+    const unsigned char *mapped_qweights;
+
     GraphBin();
+
+    // out_deg_seq is the cumulative degree of each node (as in the binary file
+    // below), the links are out_links[out_deg_seq[node - 1] .. out_deg_seq[node])
+    // the vectors are swapped into the graph, they are empty on return
+    // if half is set, they must hold the half storage (see above)
     GraphBin(
         vector<unsigned long long>& out_deg_seq,
         vector<int>& out_links,
         vector<long double>& out_w,
-        int type);
+        int type,
+        bool half = false);
 
     // binary file format is
     // 4 bytes for the number of nodes in the graph
@@ -73,8 +348,50 @@ class GraphBin
     //    deg(k)=degrees[k]-degrees[k-1]
     // 4*(sum_degrees) bytes for the links
     // IF WEIGHTED, 10*(sum_degrees) bytes for the weights in a separate file
+    //
+    // a single-file graph (see GraphFileHeader) is mapped in memory instead,
+    // and the graph runs directly on it. It is weighted if the file has
+    // weights, filename_w and type are not used
     GraphBin(const char *filename, const char *filename_w, int type);
 
+    // writes the graph in the single-file format, with weights of the given
+    // GRAPH_WEIGHT_ type (if weighted). The graph must not have hyperedges
+    void display_binary_v2(const char *outfile, int weight_type = GRAPH_WEIGHT_F64);
+
+    // compare the checksum of the mapped single-file graph to its content
+    // (this reads the whole file)
+    bool check_checksum();
+
+    // copy the arrays of the mapped file into the vectors, and unmap it
+    void detach();
+
+    // set the offsets from the cumulative degree of each node, on 4 bytes if
+    // they fit. deg_seq is empty on return
+    void set_offsets(vector<unsigned long long>& deg_seq);
+
+    // switch to (from) the compressed storage, see above
+    // the adjacency lists are sorted first (with their weights)
+    // not available for half stored graphs
+    void compress_links();
+    void uncompress_links();
+
+    // switch the weights to the given WEIGHTS_ storage, see above
+    // the integer storages need weights >= 0: with negative weights, floats
+    // are used instead
+    void quantize_weights(int storage);
+
+    // replace the weights of the stored links (in storage order) by w, in the
+    // current weight storage. w is swapped into the graph, it is empty on return
+    void set_weights(vector<long double>& w);
+
+    // adds the hyperedges to the graph, see above (hyperedge c is made of
+    // nodes[offsets[c - 1] .. offsets[c]), offsets are cumulative)
+    // the vectors are swapped into the graph, they are empty on return
+    void set_hyperedges(
+        vector<unsigned long long>& offsets,
+        vector<int>& nodes,
+        vector<long double>& w);
+
     // return the biggest weight of links in the graph
     long double max_weight();
 
@@ -86,12 +403,16 @@ class GraphBin
 
     void display(void);
     void display_reverse(void);
+    // the binary file and check_symmetry() only cover the plain edges
     void display_binary(const char *outfile);
     bool check_symmetry();
 
     // return the number of neighbors (degree) of the node
     inline int nb_neighbors(int node);
 
+    // return the number of neighbors < node of a half stored graph
+    inline int nb_rev_neighbors(int node);
+
     // return the number of self loops of the node
     inline long double nb_selfloops(int node);
 
@@ -99,61 +420,330 @@ class GraphBin
     inline long double weighted_degree(int node);
 
     // return pointers to the first neighbor and first weight of the node
+    // only valid if the graph is not half stored, mapped or compressed, use
+    // for_each_neighbor otherwise
     inline pair<vector<int>::iterator, vector<long double>::iterator> neighbors(int node);
+
+    // call f(neighbor, weight) for each neighbor of the node, in increasing
+    // order of neighbors if the adjacency lists are sorted
+    // the neighbors through hyperedges come last, once per hyperedge
+    template <class F>
+    inline void for_each_neighbor(int node, F f);
+
+    // same, without the neighbors through hyperedges
+    template <class F>
+    inline void for_each_plain_neighbor(int node, F f);
+
+    // call f(c) for each hyperedge c of the node
+    template <class F>
+    inline void for_each_hyperedge(int node, F f);
+
+    // index in hyper_nodes of the first node of hyperedge c
+    inline unsigned long long hyper_start(int c);
+
+    // same, but only for the neighbors stored at node (all of them unless the
+    // graph is half stored), in storage order
+    template <class F>
+    inline void for_each_stored_neighbor(int node, F f);
+
+    // call f(neighbor, weight_of(i)) for each stored link i of the node
+    template <class F, class W>
+    inline void for_each_stored_link(int node, F f, W weight_of);
+
+    // return the weight of the stored link i (the graph must be weighted)
+    inline long double weight(unsigned long long i);
+
+    // return the weight of the stored edge src -- dest of a half stored graph
+    inline long double mirrored_weight(int src, int dest);
+
+    // build rev_offsets and rev_links from the stored (upper) adjacency
+    void build_reverse_index();
+
+    // index in links of the first link of the node (offset(nb_nodes) is the
+    // number of stored links)
+    inline unsigned long long offset(int node);
+
+    // the arrays read by the accessors: the vectors, or the mapped file
+    inline const int *links_data();
+    inline bool has_weights();
+    inline const unsigned char *qweights_data();
+
+   private:
+    void map_v2(const char *filename);
 };
 
+// return true if the file starts with the single-file graph magic
+bool is_graph_v2(const char *filename);
+
+// 7 bits per byte, high bit set on all but the last byte
+inline unsigned varint_size(uint32_t v)
+{
+    unsigned size = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        size++;
+    }
+    return size;
+}
+
+inline unsigned char *put_varint(unsigned char *p, uint32_t v)
+{
+    while (v >= 0x80) {
+        *p++ = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (unsigned char)v;
+    return p;
+}
+
+inline uint32_t get_varint(const unsigned char *&p)
+{
+    uint32_t v = *p & 0x7f;
+    for (int shift = 7; *p++ & 0x80; shift += 7)
+        v |= (uint32_t)(*p & 0x7f) << shift;
+    return v;
+}
+
 inline int GraphBin::nb_neighbors(int node)
 {
     assert(node >= 0 && node < nb_nodes);
 
-    if (node == 0)
-        return degrees[0];
-    else
-        return (int)(degrees[node] - degrees[node - 1]);
+    int deg = (int)(offset(node + 1) - offset(node));
+    if (half)
+        deg += nb_rev_neighbors(node);
+
+    return deg;
+}
+
+inline int GraphBin::nb_rev_neighbors(int node)
+{
+    assert(half && node >= 0 && node < nb_nodes);
+
+    const unsigned char *p = &rev_links[rev_offsets[node]];
+    return (int)get_varint(p);
 }
 
 inline long double GraphBin::nb_selfloops(int node)
 {
     assert(node >= 0 && node < nb_nodes);
 
-    pair<vector<int>::iterator, vector<long double>::iterator> p = neighbors(node);
-    for (int i = 0; i < nb_neighbors(node); i++) {
-        if (*(p.first + i) == node) {
-            if (weights.size() != 0)
-                return (long double)*(p.second + i);
+    if (half) {
+        // the selfloop, if any, is the first stored neighbor
+        unsigned long long b = offset(node);
+        if (b == offset(node + 1) || links[b] != node)
+            return 0.0L;
+        return has_weights() ? weight(b) : 1.0L;
+    }
+
+    long double res = 0.0L;
+    bool found = false;
+    for_each_stored_neighbor(node, [&](int neigh, long double w) {
+        if (neigh == node && !found) {
+            res = w;
+            found = true;
+        }
+    });
+    return res;
+}
+
+inline long double GraphBin::weighted_degree(int node)
+{
+    assert(node >= 0 && node < nb_nodes);
+
+    if (mapped_w_degrees != NULL)
+        return (long double)mapped_w_degrees[node];
+
+    long double res = (nb_hyper > 0) ? hyper_degree[node] : 0.0L;
+    if (!has_weights())
+        res += (long double)nb_neighbors(node);
+    else
+        for_each_plain_neighbor(node, [&res](int, long double w) { res += w; });
+    return res;
+}
+
+inline pair<vector<int>::iterator, vector<long double>::iterator> GraphBin::neighbors(int node)
+{
+    assert(node >= 0 && node < nb_nodes);
+    assert(!half && !compressed && !mapping);
+
+    unsigned long long b = offset(node);
+    if (weights.size() != 0)
+        return make_pair(links.begin() + b, weights.begin() + b);
+    else
+        return make_pair(links.begin() + b, weights.begin());
+}
+
+template <class F>
+inline void GraphBin::for_each_neighbor(int node, F f)
+{
+    for_each_plain_neighbor(node, f);
+
+    if (nb_hyper > 0) {
+        for_each_hyperedge(node, [&](int c) {
+            for (unsigned long long i = hyper_start(c); i < hyper_offsets[c]; i++) {
+                if (hyper_nodes[i] != node)
+                    f(hyper_nodes[i], hyper_w[c]);
+            }
+        });
+    }
+}
+
+template <class F>
+inline void GraphBin::for_each_plain_neighbor(int node, F f)
+{
+    assert(node >= 0 && node < nb_nodes);
+
+    if (half) {
+        // neighbors < node: distance to the first one, then gaps
+        const unsigned char *p = &rev_links[rev_offsets[node]];
+        uint32_t nb = get_varint(p);
+        int neigh = node;
+        for (uint32_t i = 0; i < nb; i++) {
+            if (i == 0)
+                neigh -= (int)get_varint(p);
             else
-                return 1.0L;
+                neigh += (int)get_varint(p);
+            f(neigh, has_weights() ? mirrored_weight(neigh, node) : 1.0L);
         }
     }
-    return 0.0L;
+
+    for_each_stored_neighbor(node, f);
 }
 
-inline long double GraphBin::weighted_degree(int node)
+template <class F>
+inline void GraphBin::for_each_stored_neighbor(int node, F f)
+{
+    // one loop per weight storage, to keep the decoding out of the branches
+    if (!has_weights()) {
+        for_each_stored_link(node, f, [](unsigned long long) { return 1.0L; });
+        return;
+    }
+
+    switch (weight_storage) {
+        case WEIGHTS_F32: {
+            const float *w = (const float *)qweights_data();
+            for_each_stored_link(node, f, [w](unsigned long long i) { return (long double)w[i]; });
+            break;
+        }
+        case WEIGHTS_U16: {
+            const uint16_t *w = (const uint16_t *)qweights_data();
+            long double scale = weight_scale;
+            for_each_stored_link(node, f, [w, scale](unsigned long long i) { return scale * w[i]; });
+            break;
+        }
+        case WEIGHTS_U8: {
+            const uint8_t *w = qweights_data();
+            long double scale = weight_scale;
+            for_each_stored_link(node, f, [w, scale](unsigned long long i) { return scale * w[i]; });
+            break;
+        }
+        default:
+            if (mapped_weights != NULL) {
+                const double *w = mapped_weights;
+                for_each_stored_link(node, f, [w](unsigned long long i) { return (long double)w[i]; });
+            } else {
+                const long double *w = weights.data();
+                for_each_stored_link(node, f, [w](unsigned long long i) { return w[i]; });
+            }
+    }
+}
+
+template <class F, class W>
+inline void GraphBin::for_each_stored_link(int node, F f, W weight_of)
 {
     assert(node >= 0 && node < nb_nodes);
 
-    if (weights.size() == 0)
-        return (long double)nb_neighbors(node);
-    else {
-        pair<vector<int>::iterator, vector<long double>::iterator> p = neighbors(node);
-        long double res = 0.0L;
-        for (int i = 0; i < nb_neighbors(node); i++) {
-            res += (long double)*(p.second + i);
+    unsigned long long b = offset(node);
+    unsigned long long e = offset(node + 1);
+
+    if (compressed) {
+        uint32_t buf[DECODE_BLOCK];
+        uint32_t nb = (uint32_t)(e - b);
+        const unsigned char *ctrl = &clinks[clink_offsets[node]];
+        const unsigned char *data = ctrl + (nb + 3) / 4;
+        uint32_t prev = 0;
+        for (uint32_t i = 0; i < nb; i += DECODE_BLOCK) {
+            uint32_t n = min((uint32_t)DECODE_BLOCK, nb - i);
+            data = svb_decode(ctrl + i / 4, data, n, prev, buf);
+            prev = buf[n - 1];
+            for (uint32_t j = 0; j < n; j++)
+                f((int)buf[j], weight_of(b + i + j));
         }
-        return res;
+        return;
     }
+
+    const int *lk = links_data();
+    for (unsigned long long i = b; i < e; i++)
+        f(lk[i], weight_of(i));
 }
 
-inline pair<vector<int>::iterator, vector<long double>::iterator> GraphBin::neighbors(int node)
+template <class F>
+inline void GraphBin::for_each_hyperedge(int node, F f)
 {
     assert(node >= 0 && node < nb_nodes);
 
-    if (node == 0)
-        return make_pair(links.begin(), weights.begin());
-    else if (weights.size() != 0)
-        return make_pair(links.begin() + degrees[node - 1], weights.begin() + degrees[node - 1]);
-    else
-        return make_pair(links.begin() + degrees[node - 1], weights.begin());
+    if (nb_hyper == 0)
+        return;
+
+    for (unsigned long long i = node_hyper_offsets[node]; i < node_hyper_offsets[node + 1]; i++)
+        f(node_hyper[i]);
+}
+
+inline unsigned long long GraphBin::hyper_start(int c)
+{
+    assert(c >= 0 && c < nb_hyper);
+
+    return (c == 0) ? 0ULL : hyper_offsets[c - 1];
+}
+
+inline long double GraphBin::mirrored_weight(int src, int dest)
+{
+    assert(half && src <= dest);
+
+    vector<int>::iterator b = links.begin() + offset(src);
+    vector<int>::iterator e = links.begin() + offset(src + 1);
+    vector<int>::iterator it = lower_bound(b, e, dest);
+    assert(it != e && *it == dest);
+
+    return weight(it - links.begin());
+}
+
+inline unsigned long long GraphBin::offset(int node)
+{
+    assert(node >= 0 && node <= nb_nodes);
+
+    if (offset_width == 4)
+        return offsets32.data[node];
+    return offsets64.data[node];
+}
+
+inline const int *GraphBin::links_data()
+{
+    return (mapped_links != NULL) ? mapped_links : links.data();
+}
+
+inline bool GraphBin::has_weights()
+{
+    return weights.size() != 0 || mapped_weights != NULL || weight_storage != WEIGHTS_LONG_DOUBLE;
+}
+
+inline const unsigned char *GraphBin::qweights_data()
+{
+    return (mapped_qweights != NULL) ? mapped_qweights : qweights.data();
+}
+
+inline long double GraphBin::weight(unsigned long long i)
+{
+    switch (weight_storage) {
+        case WEIGHTS_F32:
+            return (long double)((const float *)qweights_data())[i];
+        case WEIGHTS_U16:
+            return weight_scale * ((const uint16_t *)qweights_data())[i];
+        case WEIGHTS_U8:
+            return weight_scale * qweights_data()[i];
+        default:
+            return (mapped_weights != NULL) ? (long double)mapped_weights[i] : weights[i];
+    }
 }
 
 #endif // LOUVAIN_GRAPHBINARY_H
@@ -0,0 +1,306 @@
+// File: graph_csr.cpp
+// -- graph built in adjacency arrays from a text edge list source file
+//-----------------------------------------------------------------------------
+// Community detection
+// Copyright (C) 2020 Mate Soos
+//
+// This file is part of Louvain algorithm.
+//
+// Louvain algorithm is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Louvain algorithm is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Louvain algorithm.  If not, see <http://www.gnu.org/licenses/>.
+//-----------------------------------------------------------------------------
+// see README.txt for more details
+
+#include "graph_csr.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#include "buffered_writer.h"
+#include "edge_list.h"
+#include "graph_binary.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+// runs f(0) ... f(nb - 1) on the threads of the library
+template <class F>
+static void run_parallel(size_t nb, F f)
+{
+    ThreadPool::shared().run_parallel(nb, function<void(size_t)>(f));
+}
+
+// calls f(edge) for the edges of bucket t of every chunk, in file order
+template <class F>
+static void for_each_bucket_edge(
+    const vector<vector<PlainEdge> >& chunks,
+    const vector<vector<uint32_t> >& buckets,
+    const vector<vector<unsigned long long> >& bucket_start,
+    size_t t,
+    F f)
+{
+    for (size_t c = 0; c < chunks.size(); c++) {
+        for (unsigned long long k = bucket_start[c][t]; k < bucket_start[c][t + 1]; k++)
+            f(chunks[c][buckets[c][k]]);
+    }
+}
+
+static bool less_node(const pair<int, long double>& a, const pair<int, long double>& b)
+{
+    return a.first < b.first;
+}
+
+GraphCSR::GraphCSR(const char *filename, int type, unsigned _nb_threads) : nb_threads(_nb_threads)
+{
+    if (nb_threads == 0)
+        nb_threads = max(1U, thread::hardware_concurrency());
+
+    vector<vector<PlainEdge> > chunks;
+    long long max_node;
+    read_edge_list(filename, type, nb_threads, chunks, max_node);
+    nb_nodes = (int)(max_node + 1);
+    bool weighted = (type == WEIGHTED);
+
+    // the node ranges, node n is in range ((n + 1) * nb_ranges - 1) / nb_nodes
+    vector<int> bounds(1, 0);
+    size_t nb_ranges = max((size_t)1, min((size_t)nb_threads, (size_t)nb_nodes));
+    for (size_t t = 1; t <= nb_ranges; t++)
+        bounds.push_back((int)((unsigned long long)nb_nodes * t / nb_ranges));
+    auto range_of = [&](uint32_t node) {
+        unsigned long long n = (unsigned long long)node + 1ULL;
+        return (size_t)((n * nb_ranges - 1ULL) / (unsigned long long)nb_nodes);
+    };
+
+    // bucket the edges of each chunk by node range (count, prefix sum,
+    // scatter): buckets[c] holds the indices in chunk c of the edges with an
+    // end in range 0, then range 1..., in file order, bucket t of chunk c is
+    // [bucket_start[c][t], bucket_start[c][t + 1]). An edge with both ends in
+    // the same range is listed once
+    size_t nb_chunks = chunks.size();
+    vector<vector<uint32_t> > buckets(nb_chunks);
+    vector<vector<unsigned long long> > bucket_start(nb_chunks);
+    run_parallel(nb_chunks, [&](size_t c) {
+        vector<unsigned long long>& b = bucket_start[c];
+        b.assign(nb_ranges + 1, 0ULL);
+        for (size_t i = 0; i < chunks[c].size(); i++) {
+            size_t rs = range_of(chunks[c][i].src), rd = range_of(chunks[c][i].dest);
+            b[rs + 1]++;
+            if (rd != rs)
+                b[rd + 1]++;
+        }
+        for (size_t t = 1; t <= nb_ranges; t++)
+            b[t] += b[t - 1];
+
+        buckets[c].resize(b[nb_ranges]);
+        vector<unsigned long long> pos(b.begin(), b.end() - 1);
+        for (size_t i = 0; i < chunks[c].size(); i++) {
+            size_t rs = range_of(chunks[c][i].src), rd = range_of(chunks[c][i].dest);
+            buckets[c][pos[rs]++] = (uint32_t)i;
+            if (rd != rs)
+                buckets[c][pos[rd]++] = (uint32_t)i;
+        }
+    });
+
+    // degrees, each thread counts the ends of the edges in its node range
+    deg_seq.assign(nb_nodes, 0ULL);
+    run_parallel(nb_ranges, [&](size_t t) {
+        uint32_t lo = bounds[t], hi = bounds[t + 1];
+        for_each_bucket_edge(chunks, buckets, bucket_start, t, [&](const PlainEdge& e) {
+            if (e.src >= lo && e.src < hi)
+                deg_seq[e.src]++;
+            if (e.dest != e.src && e.dest >= lo && e.dest < hi)
+                deg_seq[e.dest]++;
+        });
+    });
+    for (int i = 1; i < nb_nodes; i++)
+        deg_seq[i] += deg_seq[i - 1];
+
+    unsigned long long nb_links = (nb_nodes == 0) ? 0ULL : deg_seq[nb_nodes - 1];
+    links.resize(nb_links);
+    if (weighted)
+        weights.resize(nb_links);
+
+    // scatter the edges, in file order
+    run_parallel(nb_ranges, [&](size_t t) {
+        uint32_t lo = bounds[t], hi = bounds[t + 1];
+        if (lo == hi)
+            return;
+        vector<unsigned long long> pos(hi - lo);
+        for (uint32_t i = lo; i < hi; i++)
+            pos[i - lo] = start(i);
+
+        for_each_bucket_edge(chunks, buckets, bucket_start, t, [&](const PlainEdge& e) {
+            if (e.src >= lo && e.src < hi) {
+                unsigned long long k = pos[e.src - lo]++;
+                links[k] = e.dest;
+                if (weighted)
+                    weights[k] = e.weight;
+            }
+            if (e.dest != e.src && e.dest >= lo && e.dest < hi) {
+                unsigned long long k = pos[e.dest - lo]++;
+                links[k] = e.src;
+                if (weighted)
+                    weights[k] = e.weight;
+            }
+        });
+    });
+    vector<vector<PlainEdge> >().swap(chunks);
+    vector<vector<uint32_t> >().swap(buckets);
+
+    split_nodes(bounds);
+    nb_ranges = bounds.size() - 1;
+
+    // sort the neighbors and merge the duplicates (summing their weights if
+    // weighted, in order of appearance), deg gets the new degrees
+    vector<unsigned long long> deg(nb_nodes);
+    run_parallel(nb_ranges, [&](size_t t) {
+        vector<pair<int, long double> > tmp;
+        for (int node = bounds[t]; node < bounds[t + 1]; node++) {
+            unsigned long long b = start(node), e = deg_seq[node];
+            unsigned long long k = b + 1;
+            while (k < e && links[k - 1] < links[k])
+                k++;
+            if (k >= e) {
+                deg[node] = e - b;
+                continue;
+            }
+
+            if (!weighted) {
+                sort(links.begin() + b, links.begin() + e);
+                deg[node] = unique(links.begin() + b, links.begin() + e) - (links.begin() + b);
+                continue;
+            }
+
+            tmp.clear();
+            for (k = b; k < e; k++)
+                tmp.push_back(make_pair(links[k], weights[k]));
+            stable_sort(tmp.begin(), tmp.end(), less_node);
+
+            k = b;
+            for (size_t i = 0; i < tmp.size(); i++) {
+                if (k > b && links[k - 1] == tmp[i].first) {
+                    weights[k - 1] += tmp[i].second;
+                } else {
+                    links[k] = tmp[i].first;
+                    weights[k] = tmp[i].second;
+                    k++;
+                }
+            }
+            deg[node] = k - b;
+        }
+    });
+
+    // remove the gaps left by the duplicates
+    unsigned long long tot = 0ULL, old_start = 0ULL;
+    for (int node = 0; node < nb_nodes; node++) {
+        if (old_start != tot && deg[node] > 0) {
+            memmove(&links[tot], &links[old_start], deg[node] * sizeof(int));
+            if (weighted)
+                memmove(&weights[tot], &weights[old_start], deg[node] * sizeof(long double));
+        }
+        old_start = deg_seq[node];
+        tot += deg[node];
+        deg_seq[node] = tot;
+    }
+    if (tot != nb_links) {
+        links.resize(tot);
+        links.shrink_to_fit();
+        if (weighted) {
+            weights.resize(tot);
+            weights.shrink_to_fit();
+        }
+    }
+}
+
+void GraphCSR::split_nodes(vector<int>& bounds) const
+{
+    unsigned long long nb_links = (nb_nodes == 0) ? 0ULL : deg_seq[nb_nodes - 1];
+    size_t nb_ranges = max((size_t)1, min((size_t)nb_threads, (size_t)nb_nodes));
+
+    bounds.assign(1, 0);
+    for (size_t t = 1; t < nb_ranges; t++) {
+        unsigned long long target = nb_links / nb_ranges * t;
+        int b = lower_bound(deg_seq.begin(), deg_seq.end(), target) - deg_seq.begin();
+        bounds.push_back(max(bounds.back(), b));
+    }
+    bounds.push_back(nb_nodes);
+}
+
+void GraphCSR::renumber(const char *filename)
+{
+    vector<int> renum(nb_nodes, -1);
+    int nb = 0;
+
+    ofstream foutput;
+    foutput.open(filename, fstream::out);
+    BufferedWriter out(foutput);
+
+    // every neighbor has a link back, so the linked nodes are the ones with
+    // a neighbor
+    for (int i = 0; i < nb_nodes; i++) {
+        if (deg_seq[i] != start(i)) {
+            renum[i] = nb++;
+            out.put_int(i);
+            out.put_char(' ');
+            out.put_int(renum[i]);
+            out.put_char('\n');
+        }
+    }
+    out.flush();
+
+    vector<int> bounds;
+    split_nodes(bounds);
+    run_parallel(bounds.size() - 1, [&](size_t t) {
+        unsigned long long b = start(bounds[t]);
+        unsigned long long e = (bounds[t + 1] == 0) ? 0ULL : deg_seq[bounds[t + 1] - 1];
+        for (unsigned long long k = b; k < e; k++)
+            links[k] = renum[links[k]];
+    });
+
+    for (int i = 0; i < nb_nodes; i++) {
+        if (renum[i] >= 0)
+            deg_seq[renum[i]] = deg_seq[i];
+    }
+    deg_seq.resize(nb);
+    nb_nodes = nb;
+}
+
+void GraphCSR::display_binary(const char *filename, const char *filename_w, int type)
+{
+    ofstream foutput;
+    foutput.open(filename, fstream::out | fstream::binary);
+
+    // same layout as GraphPlain::display_binary(), each section at once
+    foutput.write((char *)(&nb_nodes), sizeof(int));
+    foutput.write((char *)deg_seq.data(), deg_seq.size() * sizeof(unsigned long long));
+    foutput.write((char *)links.data(), links.size() * sizeof(int));
+    foutput.close();
+
+    if (type == WEIGHTED) {
+        ofstream foutput_w;
+        foutput_w.open(filename_w, fstream::out | fstream::binary);
+        foutput_w.write((char *)weights.data(), weights.size() * sizeof(long double));
+        foutput_w.close();
+    }
+}
+
+void GraphCSR::display_binary_v2(const char *filename, int type, int weight_type)
+{
+    // the arrays are handed over to the GraphBin writer, links and weights
+    // are left empty
+    GraphBin g(deg_seq, links, weights, type, false);
+    g.display_binary_v2(filename, weight_type);
+}
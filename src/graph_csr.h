@@ -0,0 +1,72 @@
+// File: graph_csr.h
+// -- graph built in adjacency arrays from a text edge list header file
+//-----------------------------------------------------------------------------
+// Community detection
+// Copyright (C) 2020 Mate Soos
+//
+// This file is part of Louvain algorithm.
+//
+// Louvain algorithm is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Louvain algorithm is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Louvain algorithm.  If not, see <http://www.gnu.org/licenses/>.
+//-----------------------------------------------------------------------------
+// see README.txt for more details
+
+#ifndef LOUVAIN_GRAPHCSR_H
+#define LOUVAIN_GRAPHCSR_H
+
+#include <vector>
+
+#include "graph_plain.h"
+
+using namespace std;
+
+// the same graph as GraphPlain after clean(), for the converter: the edges
+// are scattered straight into adjacency arrays instead of a vector per node,
+// and every step runs on nb_threads threads (0 means one per hardware thread)
+//
+// the edges of each parsed chunk are first bucketed by node range, then each
+// thread owns a range of nodes and reads only its buckets, in file order, so
+// the neighbors of a node are in the same order as with GraphPlain and the
+// weights of duplicate edges are summed in the same order
+class GraphCSR
+{
+   public:
+    int nb_nodes;
+    unsigned nb_threads;
+
+    // cumulative degree sequence, links and (if weighted) weights, laid out
+    // as by GraphPlain::binary_to_mem()
+    vector<unsigned long long> deg_seq;
+    vector<int> links;
+    vector<long double> weights;
+
+    // reads a text edge list (see read_edge_list()), merges duplicate edges
+    // and sorts the neighbors
+    GraphCSR(const char *filename, int type, unsigned nb_threads = 0);
+
+    void renumber(const char *filename);
+
+    void display_binary(const char *filename, const char *filename_w, int type);
+    void display_binary_v2(const char *filename, int type, int weight_type = GRAPH_WEIGHT_F64);
+
+   private:
+    inline unsigned long long start(int node) const
+    {
+        return (node == 0) ? 0ULL : deg_seq[node - 1];
+    }
+
+    // node ranges of about the same number of links, one for each thread
+    void split_nodes(vector<int>& bounds) const;
+};
+
+#endif // LOUVAIN_GRAPHCSR_H
@@ -0,0 +1,494 @@
+// File: graph_external.cpp
+// -- external memory conversion of a text edge list source file
+//-----------------------------------------------------------------------------
+// Community detection
+// Copyright (C) 2020 Mate Soos
+//
+// This file is part of Louvain algorithm.
+//
+// Louvain algorithm is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Louvain algorithm is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Louvain algorithm.  If not, see <http://www.gnu.org/licenses/>.
+//-----------------------------------------------------------------------------
+// see README.txt for more details
+
+#include "graph_external.h"
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <queue>
+
+#include "buffered_writer.h"
+#include "edge_list.h"
+#include "graph_binary.h"
+
+using namespace std;
+
+// bytes of text parsed at once
+#define EXTERNAL_BLOCK_SIZE (1ULL << 20)
+// at most this many runs are merged at once, more runs are first merged by
+// groups into longer ones
+#define MAX_MERGE_RUNS 64
+// smallest read buffer of a run, in links
+#define MIN_RUN_BUFFER 4096
+
+// a link of a weighted run, the node is in the high 32 bits of key and the
+// neighbor in the low ones. An unweighted run only holds the keys
+struct RunLink {
+    uint64_t key;
+    long double w;
+};
+
+static inline uint64_t key_of(uint64_t k)
+{
+    return k;
+}
+
+static inline uint64_t key_of(const RunLink& l)
+{
+    return l.key;
+}
+
+static inline long double weight_of(uint64_t)
+{
+    return 1.0L;
+}
+
+static inline long double weight_of(const RunLink& l)
+{
+    return l.w;
+}
+
+static inline void make_link(uint64_t& k, uint64_t key, long double)
+{
+    k = key;
+}
+
+static inline void make_link(RunLink& l, uint64_t key, long double w)
+{
+    l.key = key;
+    l.w = w;
+}
+
+// b is a duplicate of a, found after it in the file
+static inline void merge_link(uint64_t&, const uint64_t&)
+{
+}
+
+static inline void merge_link(RunLink& a, const RunLink& b)
+{
+    a.w += b.w;
+}
+
+template <class T>
+static bool same_key(const T& a, const T& b)
+{
+    return key_of(a) == key_of(b);
+}
+
+static bool less_key(const RunLink& a, const RunLink& b)
+{
+    return a.key < b.key;
+}
+
+// the duplicates keep the order of the file
+static void sort_links(vector<uint64_t>& run)
+{
+    sort(run.begin(), run.end());
+}
+
+static void sort_links(vector<RunLink>& run)
+{
+    stable_sort(run.begin(), run.end(), less_key);
+}
+
+static void check_stream(const ios& s, const string& name)
+{
+    if (!s) {
+        cerr << "The file " << name << " cannot be written" << endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+// sequential reader of an array of T stored in a file
+template <class T>
+class RunReader
+{
+   public:
+    RunReader(const string& name, size_t nb) : buf(max(nb, (size_t)1)), pos(0), size(0)
+    {
+        in.open(name.c_str(), fstream::in | fstream::binary);
+        if (in.is_open() != true) {
+            cerr << "The file " << name << " cannot be read" << endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    bool next(T& out)
+    {
+        if (pos == size) {
+            in.read((char *)buf.data(), buf.size() * sizeof(T));
+            size = (size_t)in.gcount() / sizeof(T);
+            pos = 0;
+            if (size == 0)
+                return false;
+        }
+        out = buf[pos++];
+        return true;
+    }
+
+   private:
+    ifstream in;
+    vector<T> buf;
+    size_t pos;
+    size_t size;
+};
+
+// k-way merge of runs[first .. last), calls emit(link) in key order, the
+// duplicates merged. On equal keys the earlier run goes first, so the weights
+// are summed in the order of the file
+template <class T, class F>
+static void merge_runs(const vector<string>& runs, size_t first, size_t last, size_t memory, F emit)
+{
+    size_t k = last - first;
+    size_t nb = max((size_t)MIN_RUN_BUFFER, memory / max(k, (size_t)1) / sizeof(T));
+
+    vector<unique_ptr<RunReader<T> > > readers;
+    vector<T> head(k);
+    priority_queue<pair<uint64_t, size_t>, vector<pair<uint64_t, size_t> >, greater<pair<uint64_t, size_t> > > heap;
+    for (size_t i = 0; i < k; i++) {
+        readers.push_back(unique_ptr<RunReader<T> >(new RunReader<T>(runs[first + i], nb)));
+        if (readers[i]->next(head[i]))
+            heap.push(make_pair(key_of(head[i]), i));
+    }
+
+    T cur = T();
+    bool has_cur = false;
+    while (!heap.empty()) {
+        size_t i = heap.top().second;
+        heap.pop();
+
+        if (has_cur && key_of(cur) == key_of(head[i])) {
+            merge_link(cur, head[i]);
+        } else {
+            if (has_cur)
+                emit(cur);
+            cur = head[i];
+            has_cur = true;
+        }
+
+        if (readers[i]->next(head[i]))
+            heap.push(make_pair(key_of(head[i]), i));
+    }
+    if (has_cur)
+        emit(cur);
+}
+
+GraphExternal::GraphExternal(const char *filename, int _type, size_t _memory, const string& _tmp_prefix) :
+    nb_nodes(0), type(_type), memory(_memory), tmp_prefix(_tmp_prefix)
+{
+    if (type == WEIGHTED)
+        sort_runs<RunLink>(filename);
+    else
+        sort_runs<uint64_t>(filename);
+}
+
+GraphExternal::~GraphExternal()
+{
+    for (size_t i = 0; i < tmp_files.size(); i++)
+        remove(tmp_files[i].c_str());
+}
+
+string GraphExternal::new_run()
+{
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".run%d", (int)tmp_files.size());
+    tmp_files.push_back(tmp_prefix + suffix);
+    return tmp_files.back();
+}
+
+template <class T>
+void GraphExternal::sort_runs(const char *filename)
+{
+    // both directions of an edge go in the same run
+    size_t capacity = max((size_t)2, memory / sizeof(T));
+    vector<T> run;
+    run.reserve(capacity);
+
+    auto flush = [&]() {
+        sort_links(run);
+        // the duplicates of a weighted run are kept for the merge: summed
+        // here, they would no longer be added in the order of the file
+        size_t k = run.size();
+        if (type != WEIGHTED)
+            k = unique(run.begin(), run.end(), same_key<T>) - run.begin();
+
+        string name = new_run();
+        runs.push_back(name);
+        ofstream foutput;
+        foutput.open(name.c_str(), fstream::out | fstream::binary);
+        foutput.write((char *)run.data(), k * sizeof(T));
+        foutput.close();
+        check_stream(foutput, name);
+        run.clear();
+    };
+
+    long long max_node = -1;
+    read_edge_list_blocks(filename, type, EXTERNAL_BLOCK_SIZE, 1, [&](vector<PlainEdge>& edges) {
+        for (size_t i = 0; i < edges.size(); i++) {
+            const PlainEdge& e = edges[i];
+            if (run.size() + 2 > capacity)
+                flush();
+
+            uint32_t m = max(e.src, e.dest);
+            if ((long long)m > max_node) {
+                max_node = m;
+                if (linked.size() <= m)
+                    linked.resize(max((size_t)m + 1, linked.size() * 2), false);
+            }
+            linked[e.src] = true;
+            linked[e.dest] = true;
+
+            T l;
+            make_link(l, ((uint64_t)e.src << 32) | e.dest, e.weight);
+            run.push_back(l);
+            if (e.src != e.dest) {
+                make_link(l, ((uint64_t)e.dest << 32) | e.src, e.weight);
+                run.push_back(l);
+            }
+        }
+    });
+    if (!run.empty())
+        flush();
+    vector<T>().swap(run);
+
+    nb_nodes = (int)(max_node + 1);
+    linked.resize(nb_nodes);
+
+    // merge consecutive runs until they can all be merged at once
+    while (runs.size() > MAX_MERGE_RUNS) {
+        vector<string> merged;
+        for (size_t first = 0; first < runs.size(); first += MAX_MERGE_RUNS) {
+            size_t last = min(runs.size(), first + MAX_MERGE_RUNS);
+            string name = new_run();
+            merged.push_back(name);
+
+            ofstream foutput;
+            foutput.open(name.c_str(), fstream::out | fstream::binary);
+            {
+                BufferedWriter out(foutput);
+                merge_runs<T>(runs, first, last, memory, [&](const T& l) {
+                    out.put((const char *)&l, sizeof(T));
+                });
+            }
+            foutput.close();
+            check_stream(foutput, name);
+
+            for (size_t i = first; i < last; i++)
+                remove(runs[i].c_str());
+        }
+        runs.swap(merged);
+    }
+}
+
+template <class T, class F>
+void GraphExternal::merge(F f)
+{
+    merge_runs<T>(runs, 0, runs.size(), memory, [&](const T& l) {
+        int node = (int)(key_of(l) >> 32);
+        int neigh = (int)(uint32_t)key_of(l);
+        if (!renum.empty()) {
+            node = renum[node];
+            neigh = renum[neigh];
+        }
+        f(node, neigh, weight_of(l));
+    });
+}
+
+void GraphExternal::renumber(const char *filename)
+{
+    renum.assign(nb_nodes, -1);
+    int nb = 0;
+
+    ofstream foutput;
+    foutput.open(filename, fstream::out);
+    BufferedWriter out(foutput);
+
+    for (int i = 0; i < nb_nodes; i++) {
+        if (linked[i]) {
+            renum[i] = nb++;
+            out.put_int(i);
+            out.put_char(' ');
+            out.put_int(renum[i]);
+            out.put_char('\n');
+        }
+    }
+    nb_nodes = nb;
+}
+
+void GraphExternal::display_binary(const char *filename, const char *filename_w)
+{
+    bool weighted = (type == WEIGHTED);
+
+    // same layout as GraphPlain::display_binary(), the links are streamed
+    // through a second handle on the file while the degrees are counted
+    ofstream foutput;
+    foutput.open(filename, fstream::out | fstream::binary | fstream::trunc);
+    foutput.write((char *)(&nb_nodes), sizeof(int));
+    check_stream(foutput, filename);
+
+    fstream foutput_l;
+    foutput_l.open(filename, fstream::in | fstream::out | fstream::binary);
+    foutput_l.seekp(sizeof(int) + (unsigned long long)nb_nodes * sizeof(unsigned long long));
+
+    ofstream foutput_w;
+    if (weighted)
+        foutput_w.open(filename_w, fstream::out | fstream::binary);
+
+    {
+        BufferedWriter out_deg(foutput);
+        BufferedWriter out_links(foutput_l);
+        BufferedWriter out_w(foutput_w);
+
+        int cur = 0;
+        unsigned long long tot = 0ULL;
+        auto write_link = [&](int node, int neigh, long double w) {
+            for (; cur < node; cur++)
+                out_deg.put((char *)&tot, sizeof(tot));
+            tot++;
+            out_links.put_int32(neigh);
+            if (weighted)
+                out_w.put((char *)&w, sizeof(w));
+        };
+        if (weighted)
+            merge<RunLink>(write_link);
+        else
+            merge<uint64_t>(write_link);
+        for (; cur < nb_nodes; cur++)
+            out_deg.put((char *)&tot, sizeof(tot));
+    }
+
+    foutput.close();
+    foutput_l.close();
+    check_stream(foutput, filename);
+    check_stream(foutput_l, filename);
+    if (weighted) {
+        foutput_w.close();
+        check_stream(foutput_w, filename_w);
+    }
+}
+
+void GraphExternal::display_binary_v2(const char *filename, int weight_type)
+{
+    bool weighted = (type == WEIGHTED);
+
+    // the offsets come first in the file: the links and weights are merged
+    // into two more temporary files while the degrees are counted
+    vector<unsigned long long> deg(nb_nodes, 0ULL);
+    long double min_w = 0.0L, max_w = 0.0L;
+
+    string links_file = new_run();
+    string weights_file = new_run();
+
+    ofstream foutput_l, foutput_w;
+    foutput_l.open(links_file.c_str(), fstream::out | fstream::binary);
+    if (weighted)
+        foutput_w.open(weights_file.c_str(), fstream::out | fstream::binary);
+    {
+        BufferedWriter out_links(foutput_l);
+        BufferedWriter out_w(foutput_w);
+
+        auto write_link = [&](int node, int neigh, long double w) {
+            deg[node]++;
+            out_links.put_int32(neigh);
+            if (weighted) {
+                min_w = min(min_w, w);
+                max_w = max(max_w, w);
+                out_w.put((char *)&w, sizeof(w));
+            }
+        };
+        if (weighted)
+            merge<RunLink>(write_link);
+        else
+            merge<uint64_t>(write_link);
+    }
+    foutput_l.close();
+    check_stream(foutput_l, links_file);
+    if (weighted) {
+        foutput_w.close();
+        check_stream(foutput_w, weights_file);
+    }
+
+    // as GraphBin::display_binary_v2()
+    bool as_int = weighted && (weight_type == GRAPH_WEIGHT_U16 || weight_type == GRAPH_WEIGHT_U8);
+    long double max_q = (weight_type == GRAPH_WEIGHT_U16) ? 65535.0L : 255.0L;
+    double scale = 1.0;
+    if (as_int) {
+        if (min_w < 0.0L) {
+            cerr << "The graph has negative weights, they cannot be written as unsigned integers"
+                 << endl;
+            exit(EXIT_FAILURE);
+        }
+        if (max_w > 0.0L)
+            scale = (double)(max_w / max_q);
+    }
+
+    unsigned long long nb_links = 0ULL;
+    for (int i = 0; i < nb_nodes; i++)
+        nb_links += deg[i];
+
+    GraphFileWriter out(filename, nb_nodes, nb_links, weighted ? weight_type : GRAPH_WEIGHT_NONE, scale);
+
+    unsigned long long tot = 0ULL;
+    out.add_offset(tot);
+    for (int i = 0; i < nb_nodes; i++) {
+        tot += deg[i];
+        out.add_offset(tot);
+    }
+
+    {
+        RunReader<int> in(links_file, memory / 2 / sizeof(int) + 1);
+        int neigh;
+        while (in.next(neigh))
+            out.add_link(neigh);
+    }
+
+    // the weighted degrees are those of the weights read back from the file,
+    // the weights are in node order
+    vector<long double> w_deg(weighted ? nb_nodes : 0, 0.0L);
+    if (weighted) {
+        RunReader<long double> in(weights_file, memory / 2 / sizeof(long double) + 1);
+        long double w;
+        for (int i = 0; i < nb_nodes; i++) {
+            for (unsigned long long k = 0ULL; k < deg[i] && in.next(w); k++) {
+                out.add_weight(w);
+                w_deg[i] += out.stored_weight(w);
+            }
+        }
+    }
+
+    for (int i = 0; i < nb_nodes; i++)
+        out.add_node_w(1);
+
+    long double total_weight = 0.0L;
+    for (int i = 0; i < nb_nodes; i++) {
+        long double d = weighted ? w_deg[i] : (long double)deg[i];
+        out.add_degree(d);
+        total_weight += d;
+    }
+
+    out.close(total_weight, nb_nodes);
+}
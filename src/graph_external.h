@@ -0,0 +1,83 @@
+// File: graph_external.h
+// -- external memory conversion of a text edge list header file
+//-----------------------------------------------------------------------------
+// Community detection
+// Copyright (C) 2020 Mate Soos
+//
+// This file is part of Louvain algorithm.
+//
+// Louvain algorithm is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Louvain algorithm is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Louvain algorithm.  If not, see <http://www.gnu.org/licenses/>.
+//-----------------------------------------------------------------------------
+// see README.txt for more details
+
+#ifndef LOUVAIN_GRAPHEXTERNAL_H
+#define LOUVAIN_GRAPHEXTERNAL_H
+
+#include <string>
+#include <vector>
+
+#include "graph_plain.h"
+
+using namespace std;
+
+// the same graph as GraphCSR, for edge lists that do not fit in memory
+//
+// the links (both directions of each edge) are collected by runs of at most
+// memory bytes, each run is sorted and written to a temporary file (named
+// tmp_prefix followed by a number), and the runs are merged into the binary
+// graph, summing the weights of duplicate links in the order of the file
+// only a few arrays of one entry per node stay in memory
+class GraphExternal
+{
+   public:
+    int nb_nodes;
+
+    // reads the text edge list (see read_edge_list()) and writes the sorted runs
+    GraphExternal(const char *filename, int type, size_t memory, const string& tmp_prefix);
+
+    // removes the temporary files
+    ~GraphExternal();
+
+    void renumber(const char *filename);
+
+    void display_binary(const char *filename, const char *filename_w);
+    void display_binary_v2(const char *filename, int weight_type = GRAPH_WEIGHT_F64);
+
+   private:
+    GraphExternal(const GraphExternal &);
+    GraphExternal &operator=(const GraphExternal &);
+
+    int type;
+    size_t memory;
+    string tmp_prefix;
+    vector<string> tmp_files;
+    vector<string> runs;
+
+    // the nodes with a link, and their new number if renumbered (-1 otherwise)
+    vector<bool> linked;
+    vector<int> renum;
+
+    // name of a new temporary file
+    string new_run();
+
+    // merges the runs into a single sorted sequence, calls f(node, neighbor,
+    // weight) for each link (numbered as in the output), duplicates merged
+    template <class T, class F>
+    void merge(F f);
+
+    template <class T>
+    void sort_runs(const char *filename);
+};
+
+#endif // LOUVAIN_GRAPHEXTERNAL_H
@@ -31,17 +31,64 @@
 // see README.txt for more details
 
 #include "graph_plain.h"
+#include "edge_list.h"
+#include "graph_binary.h"
+#include "MersenneTwister.h"
 
 using namespace std;
 
-GraphPlain::GraphPlain()
+// up to this size, the neighbor lists are sorted by insertion in clean()
+#define INSERTION_SORT_MAX 32
+
+// the text edge list is parsed by blocks of this many bytes per thread, the
+// edges of a block are added before the next round is parsed
+#define PLAIN_BLOCK_SIZE (4ULL << 20)
+
+GraphPlain::GraphPlain() : half(false)
+{
+}
+
+void GraphPlain::set_half(bool _half)
 {
+    if (_half == half)
+        return;
+    half = _half;
+
+    if (half) {
+        // drop the direction stored at the bigger endpoint
+        for (unsigned int i = 0; i < links.size(); i++) {
+            vector<pair<int, long double> > v;
+            for (unsigned int j = 0; j < links[i].size(); j++) {
+                if (links[i][j].first >= (int)i)
+                    v.push_back(links[i][j]);
+            }
+            links[i].swap(v);
+        }
+    } else {
+        // the neighbors < i go first, in increasing order
+        vector<vector<pair<int, long double> > > lower(links.size());
+        for (unsigned int i = 0; i < links.size(); i++) {
+            for (unsigned int j = 0; j < links[i].size(); j++) {
+                if (links[i][j].first != (int)i)
+                    lower[links[i][j].first].push_back(make_pair(i, links[i][j].second));
+            }
+        }
+        for (unsigned int i = 0; i < links.size(); i++) {
+            lower[i].insert(lower[i].end(), links[i].begin(), links[i].end());
+            links[i].swap(lower[i]);
+        }
+    }
 }
 
 void GraphPlain::add_edge(uint32_t src, uint32_t dest, long double weight)
 {
     if (links.size() <= max(src, dest) + 1) {
-        links.resize(max(src, dest) + 1);
+        grow(max(src, dest) + 1);
+    }
+
+    if (half) {
+        links[min(src, dest)].push_back(make_pair(max(src, dest), weight));
+        return;
     }
 
     links[src].push_back(make_pair(dest, weight));
@@ -50,42 +97,90 @@ void GraphPlain::add_edge(uint32_t src, uint32_t dest, long double weight)
     }
 }
 
-
-GraphPlain::GraphPlain(const char *filename, int type)
+// removes the links to dest from the adjacency list l
+static void remove_link(vector<pair<int, long double> >& l, int dest)
 {
-    ifstream finput;
-    finput.open(filename, fstream::in);
-    if (finput.is_open() != true) {
-        cerr << "The file " << filename << " does not exist" << endl;
-        exit(EXIT_FAILURE);
+    size_t k = 0;
+    for (size_t j = 0; j < l.size(); j++) {
+        if (l[j].first != dest)
+            l[k++] = l[j];
     }
+    l.resize(k);
+}
 
-    unsigned long long nb_links = 0ULL;
+void GraphPlain::remove_edge(uint32_t src, uint32_t dest)
+{
+    if (max(src, dest) >= links.size())
+        return;
 
-    while (!finput.eof()) {
-        unsigned int src, dest;
-        long double weight = 1.0L;
+    if (half) {
+        remove_link(links[min(src, dest)], max(src, dest));
+        return;
+    }
 
-        if (type == WEIGHTED) {
-            finput >> src >> dest >> weight;
-        } else {
-            finput >> src >> dest;
+    remove_link(links[src], dest);
+    if (src != dest)
+        remove_link(links[dest], src);
+}
+
+void GraphPlain::clear()
+{
+    for (size_t i = 0; i < links.size(); i++) {
+        if (links[i].capacity() > 0) {
+            links[i].clear();
+            spare.push_back(vector<pair<int, long double> >());
+            spare.back().swap(links[i]);
         }
+    }
+    links.clear();
 
-        if (finput) {
-            if (links.size() <= max(src, dest) + 1) {
-                links.resize(max(src, dest) + 1);
-            }
+    hyper_offsets.clear();
+    hyper_nodes.clear();
+    hyper_w.clear();
+}
+
+void GraphPlain::grow(size_t nb_nodes)
+{
+    size_t old = links.size();
+    links.resize(nb_nodes);
+    for (size_t i = old; i < nb_nodes && !spare.empty(); i++) {
+        links[i].swap(spare.back());
+        spare.pop_back();
+    }
+}
 
-            links[src].push_back(make_pair(dest, weight));
-            if (src != dest)
-                links[dest].push_back(make_pair(src, weight));
+void GraphPlain::add_hyperedge(const uint32_t *first, const uint32_t *last, long double weight)
+{
+    uint32_t max_node = *max_element(first, last);
+    if (links.size() <= max_node)
+        grow(max_node + 1);
+
+    hyper_nodes.insert(hyper_nodes.end(), first, last);
+    hyper_offsets.push_back(hyper_nodes.size());
+    hyper_w.push_back(weight);
+}
 
-            nb_links += 1ULL;
+void GraphPlain::expand_hyperedges()
+{
+    for (size_t c = 0; c < hyper_w.size(); c++) {
+        unsigned long long b = (c == 0) ? 0ULL : hyper_offsets[c - 1];
+        for (unsigned long long i = b; i < hyper_offsets[c]; i++) {
+            for (unsigned long long j = i + 1; j < hyper_offsets[c]; j++)
+                add_edge(hyper_nodes[i], hyper_nodes[j], hyper_w[c]);
         }
     }
 
-    finput.close();
+    vector<unsigned long long>().swap(hyper_offsets);
+    vector<int>().swap(hyper_nodes);
+    vector<long double>().swap(hyper_w);
+}
+
+GraphPlain::GraphPlain(const char *filename, int type, unsigned nb_threads) : half(false)
+{
+    read_edge_list_blocks(filename, type, PLAIN_BLOCK_SIZE, nb_threads, [&](vector<PlainEdge>& edges) {
+        for (size_t i = 0; i < edges.size(); i++)
+            add_edge(edges[i].src, edges[i].dest, edges[i].weight);
+    });
 }
 
 void GraphPlain::renumber(int type, char *filename)
@@ -100,6 +195,10 @@ void GraphPlain::renumber(int type, char *filename)
     for (unsigned int i = 0; i < links.size(); i++) {
         if (links[i].size() > 0)
             linked[i] = 1;
+        if (half) {
+            for (unsigned int j = 0; j < links[i].size(); j++)
+                linked[links[i][j].first] = 1;
+        }
     }
 
     for (unsigned int i = 0; i < links.size(); i++) {
@@ -120,28 +219,72 @@ void GraphPlain::renumber(int type, char *filename)
     links.resize(nb);
 }
 
+static bool less_node(const pair<int, long double>& a, const pair<int, long double>& b)
+{
+    return a.first < b.first;
+}
+
+// sorts the neighbors and merges the duplicates in place: the first weight is
+// kept if unweighted, the weights are summed in order of appearance otherwise
 void GraphPlain::clean(int type)
 {
     for (unsigned int i = 0; i < links.size(); i++) {
-        map<int, long double> m;
-        map<int, long double>::iterator it;
+        vector<pair<int, long double> >& l = links[i];
+        if (l.size() < 2)
+            continue;
+        if (l.size() <= INSERTION_SORT_MAX) {
+            // stable, and no temporary buffer
+            for (size_t j = 1; j < l.size(); j++) {
+                pair<int, long double> x = l[j];
+                size_t k = j;
+                for (; k > 0 && x.first < l[k - 1].first; k--)
+                    l[k] = l[k - 1];
+                l[k] = x;
+            }
+        } else {
+            stable_sort(l.begin(), l.end(), less_node);
+        }
 
-        for (unsigned int j = 0; j < links[i].size(); j++) {
-            it = m.find(links[i][j].first);
-            if (it == m.end())
-                m.insert(make_pair(links[i][j].first, links[i][j].second));
-            else if (type == WEIGHTED)
-                it->second += links[i][j].second;
+        size_t k = 0;
+        for (size_t j = 0; j < l.size(); j++) {
+            if (k > 0 && l[k - 1].first == l[j].first) {
+                if (type == WEIGHTED)
+                    l[k - 1].second += l[j].second;
+            } else {
+                l[k++] = l[j];
+            }
         }
+        l.resize(k);
+    }
+}
 
-        vector<pair<int, long double> > v;
-        for (it = m.begin(); it != m.end(); it++)
-            v.push_back(*it);
-        links[i].clear();
-        links[i] = v;
+void GraphPlain::sort_links()
+{
+    for (unsigned int i = 0; i < links.size(); i++) {
+        if (!is_sorted(links[i].begin(), links[i].end()))
+            sort(links[i].begin(), links[i].end());
     }
 }
 
+bool GraphPlain::check_clean(unsigned nb_samples)
+{
+    if (links.empty())
+        return true;
+
+    // fixed seed: the check must not depend on (nor change) the seed of the
+    // community detection
+    MTRand::uint32 seed = 0;
+    MTRand rand(seed);
+    for (unsigned s = 0; s < nb_samples; s++) {
+        unsigned int i = rand.randInt(links.size() - 1);
+        for (unsigned int j = 1; j < links[i].size(); j++) {
+            if (links[i][j].first == links[i][j - 1].first)
+                return false;
+        }
+    }
+    return true;
+}
+
 void GraphPlain::display(int type)
 {
     for (unsigned int i = 0; i < links.size(); i++) {
@@ -191,6 +334,14 @@ void GraphPlain::binary_to_mem(
 
 void GraphPlain::display_binary(const char *filename, const char *filename_w, int type)
 {
+    if (half) {
+        // the file format stores both directions
+        GraphPlain full(*this);
+        full.set_half(false);
+        full.display_binary(filename, filename_w, type);
+        return;
+    }
+
     ofstream foutput;
     foutput.open(filename, fstream::out | fstream::binary);
 
@@ -228,3 +379,14 @@ void GraphPlain::display_binary(const char *filename, const char *filename_w, in
         foutput_w.close();
     }
 }
+
+void GraphPlain::display_binary_v2(const char *filename, int type, int weight_type)
+{
+    vector<unsigned long long> deg_seq;
+    vector<int> out_links;
+    vector<long double> out_w;
+    binary_to_mem(deg_seq, out_links, out_w, type);
+
+    GraphBin g(deg_seq, out_links, out_w, type, half);
+    g.display_binary_v2(filename, weight_type);
+}
@@ -43,6 +43,13 @@
 #define WEIGHTED 0
 #define UNWEIGHTED 1
 
+// weights of a single-file graph (see graph_binary.h)
+#define GRAPH_WEIGHT_NONE 0
+#define GRAPH_WEIGHT_F64 1
+#define GRAPH_WEIGHT_F32 2
+#define GRAPH_WEIGHT_U16 3
+#define GRAPH_WEIGHT_U8 4
+
 using namespace std;
 
 class GraphPlain
@@ -50,19 +57,73 @@ class GraphPlain
    public:
     vector<vector<pair<int, long double> > > links;
 
+    // half storage: every edge is kept only once, at its smaller endpoint
+    // (i.e. links[i] only holds neighbors >= i)
+    bool half;
+
+    // hyperedges, each one standing for the clique over its nodes with the
+    // same weight on every edge (see GraphBin)
+    // hyperedge c is made of hyper_nodes[hyper_offsets[c - 1] .. hyper_offsets[c])
+    vector<unsigned long long> hyper_offsets;
+    vector<int> hyper_nodes;
+    vector<long double> hyper_w;
+
     GraphPlain();
-    GraphPlain(const char *filename, int type);
+
+    // reads a text edge list, see read_edge_list() for the format
+    // the file is parsed by nb_threads threads (0 means one per hardware thread)
+    // by rounds of blocks, so only a few blocks of parsed edges are held at once
+    GraphPlain(const char *filename, int type, unsigned nb_threads = 0);
+
+    // switch the storage mode, converting the edges already added
+    void set_half(bool _half);
 
     void add_edge(uint32_t src, uint32_t dst, long double weight = 1.0L);
+
+    // removes every copy of the edge, in both directions
+    void remove_edge(uint32_t src, uint32_t dst);
+
+    // removes all the nodes and edges, but keeps the memory of the neighbor
+    // lists for the next graph
+    void clear();
+
+    // the nodes of [first, last) must be distinct
+    void add_hyperedge(const uint32_t *first, const uint32_t *last, long double weight);
+
+    // replace the hyperedges by the edges of their cliques
+    void expand_hyperedges();
     void clean(int type);
+
+    // cheaper replacement for clean() when the input is known to hold no
+    // duplicate edge: only sorts the neighbor lists (if they are not already)
+    void sort_links();
+
+    // checks nb_samples random nodes for duplicate edges, the only thing
+    // clean() would fix after sort_links() as add_edge() keeps the graph
+    // symmetric. Returns false if one is found
+    bool check_clean(unsigned nb_samples);
     void renumber(int type, char *filename);
     void display(int type);
     void display_binary(const char *filename, const char *filename_w, int type);
+
+    // writes the graph in the single-file binary format (see GraphBin), with
+    // weights of the given GRAPH_WEIGHT_ type
+    void display_binary_v2(const char *filename, int type, int weight_type = GRAPH_WEIGHT_F64);
+
+    // outputs the graph as stored: both directions of each edge, or the half
+    // storage expected by GraphBin if half is set
     void binary_to_mem(
         vector<unsigned long long>& out_deg_seq,
         vector<int>& out_links,
         vector<long double>& out_w,
         int type);
+
+    // adds nodes up to nb_nodes, reusing the lists kept by clear()
+    void grow(size_t nb_nodes);
+
+   private:
+    // the neighbor lists of the nodes removed by clear(), empty
+    vector<vector<pair<int, long double> > > spare;
 };
 
 #endif // LOUVAIN_GRAPHPLAIN
@@ -0,0 +1,251 @@
+// File: hierarchy_tree.cpp
+// -- community tree (text and binary formats) source file
+//-----------------------------------------------------------------------------
+// Community detection
+// Copyright (C) 2020 Mate Soos
+//
+// This file is part of Louvain algorithm.
+//
+// Louvain algorithm is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Louvain algorithm is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Louvain algorithm.  If not, see <http://www.gnu.org/licenses/>.
+//-----------------------------------------------------------------------------
+// see README.txt for more details
+
+#include "hierarchy_tree.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "edge_list.h"
+
+using namespace std;
+
+static uint64_t align_pos(uint64_t pos)
+{
+    return (pos + TREE_ALIGN - 1) / TREE_ALIGN * TREE_ALIGN;
+}
+
+HierarchyTree::HierarchyTree() : nb_levels(0), table(NULL)
+{
+}
+
+bool is_tree_binary(const char *filename)
+{
+    ifstream finput;
+    finput.open(filename, fstream::in | fstream::binary);
+
+    char magic[8];
+    finput.read(magic, sizeof(magic));
+    return finput && memcmp(magic, TREE_MAGIC, sizeof(magic)) == 0;
+}
+
+void HierarchyTree::read(const char *filename)
+{
+    if (is_tree_binary(filename))
+        map_binary(filename);
+    else
+        read_text(filename);
+}
+
+void HierarchyTree::read_text(const char *filename)
+{
+    if (!file.open(filename)) {
+        cerr << "The file " << filename << " does not exist" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    const char *p = file.data;
+    const char *end = file.data + file.size;
+    long long line = 0;
+    while (p < end) {
+        line++;
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+            p++;
+        if (p == end)
+            break;
+        if (*p == '\n') {
+            p++;
+            continue;
+        }
+
+        uint32_t node, comm;
+        bool valid = scan_node(p, end, node);
+        while (valid && p < end && (*p == ' ' || *p == '\t'))
+            p++;
+        valid = valid && scan_node(p, end, comm) && comm <= (uint32_t)INT32_MAX;
+        if (valid && node == 0)
+            levels.resize(levels.size() + 1);
+        if (!valid || levels.empty() || node != levels.back().size()) {
+            cerr << "The file " << filename << " is not a valid tree (line " << line << ")" << endl;
+            exit(EXIT_FAILURE);
+        }
+        levels.back().push_back((int)comm);
+
+        const char *nl = (const char *)memchr(p, '\n', end - p);
+        p = nl ? nl + 1 : end;
+    }
+    file.close();
+
+    nb_levels = levels.size();
+}
+
+void HierarchyTree::map_binary(const char *filename)
+{
+    if (!file.open(filename, false)) {
+        cerr << "The file " << filename << " does not exist" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    TreeFileHeader h;
+    bool valid = file.size >= sizeof(h);
+    if (valid) {
+        memcpy(&h, file.data, sizeof(h));
+        if (h.byte_order != TREE_BYTE_ORDER || h.version != TREE_VERSION ||
+            h.header_size != sizeof(h)) {
+            cerr << "The file " << filename << " has an unsupported format (version " << h.version
+                 << ")" << endl;
+            exit(EXIT_FAILURE);
+        }
+        valid = h.file_size == file.size && h.nb_levels <= (uint32_t)INT32_MAX &&
+                h.table_pos % TREE_ALIGN == 0 && h.table_pos <= file.size &&
+                h.nb_levels <= (file.size - h.table_pos) / sizeof(TreeLevel);
+    }
+
+    // every array must be aligned and lie within the file
+    if (valid) {
+        table = (const TreeLevel *)(file.data + h.table_pos);
+        uint64_t nb_nodes0 = (h.nb_levels > 0) ? table[0].nb_nodes : 0ULL;
+        for (uint32_t l = 0; l < h.nb_levels && valid; l++) {
+            uint64_t pos[2] = {table[l].level_pos, table[l].flat_pos};
+            uint64_t len[2] = {table[l].nb_nodes * sizeof(int), nb_nodes0 * sizeof(int)};
+            valid = table[l].nb_nodes <= file.size / sizeof(int);
+            for (int i = 0; i < 2 && valid; i++) {
+                if ((i == 0 || pos[i] != 0ULL) &&
+                    (pos[i] % TREE_ALIGN != 0 || pos[i] > file.size || len[i] > file.size - pos[i]))
+                    valid = false;
+            }
+        }
+    }
+    if (!valid) {
+        cerr << "The file " << filename << " is not a valid tree" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    nb_levels = (int)h.nb_levels;
+}
+
+unsigned long long HierarchyTree::level_size(int l)
+{
+    if (table != NULL)
+        return table[l].nb_nodes;
+    return levels[l].size();
+}
+
+const int *HierarchyTree::level(int l)
+{
+    if (table != NULL)
+        return (const int *)(file.data + table[l].level_pos);
+    return levels[l].data();
+}
+
+const int *HierarchyTree::communities(int l, vector<int>& buf)
+{
+    if (l > 0 && table != NULL && table[l - 1].flat_pos != 0ULL)
+        return (const int *)(file.data + table[l - 1].flat_pos);
+
+    unsigned long long n = (nb_levels > 0) ? level_size(0) : 0ULL;
+    buf.resize(n);
+    for (unsigned long long node = 0; node < n; node++)
+        buf[node] = (int)node;
+
+    for (int k = 0; k < l; k++) {
+        const int *c = level(k);
+        unsigned long long size = level_size(k);
+        for (unsigned long long node = 0; node < n; node++) {
+            if ((unsigned long long)buf[node] >= size) {
+                cerr << "The tree is not valid (level " << k << ")" << endl;
+                exit(EXIT_FAILURE);
+            }
+            buf[node] = c[buf[node]];
+        }
+    }
+    return buf.data();
+}
+
+void write_tree_binary(const char *filename, const vector<vector<int> >& levels, bool flatten)
+{
+    ofstream foutput;
+    foutput.open(filename, fstream::out | fstream::binary);
+    if (foutput.is_open() != true) {
+        cerr << "The file " << filename << " cannot be written" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    TreeFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, TREE_MAGIC, sizeof(h.magic));
+    h.version = TREE_VERSION;
+    h.byte_order = TREE_BYTE_ORDER;
+    h.header_size = sizeof(h);
+    h.nb_levels = levels.size();
+
+    // the positions of every array are known beforehand
+    uint64_t nb_nodes0 = levels.empty() ? 0ULL : levels[0].size();
+    vector<TreeLevel> table(levels.size());
+    h.table_pos = align_pos(sizeof(h));
+    uint64_t pos = align_pos(h.table_pos + table.size() * sizeof(TreeLevel));
+    for (size_t l = 0; l < levels.size(); l++) {
+        table[l].nb_nodes = levels[l].size();
+        table[l].level_pos = pos;
+        pos = align_pos(pos + levels[l].size() * sizeof(int));
+        table[l].flat_pos = 0ULL;
+        if (flatten) {
+            table[l].flat_pos = pos;
+            pos = align_pos(pos + nb_nodes0 * sizeof(int));
+        }
+    }
+    h.file_size = pos;
+
+    static const char zeros[TREE_ALIGN] = {0};
+    uint64_t cur = 0ULL;
+    // pads up to the position, then writes
+    auto write_at = [&](uint64_t at, const void *data, size_t size) {
+        foutput.write(zeros, at - cur);
+        foutput.write((const char *)data, size);
+        cur = at + size;
+    };
+
+    write_at(0ULL, &h, sizeof(h));
+    write_at(h.table_pos, table.data(), table.size() * sizeof(TreeLevel));
+
+    vector<int> flat(nb_nodes0);
+    for (uint64_t node = 0; node < nb_nodes0; node++)
+        flat[node] = (int)node;
+    for (size_t l = 0; l < levels.size(); l++) {
+        write_at(table[l].level_pos, levels[l].data(), levels[l].size() * sizeof(int));
+        if (flatten) {
+            for (uint64_t node = 0; node < nb_nodes0; node++) {
+                if ((size_t)flat[node] >= levels[l].size()) {
+                    cerr << "The tree is not valid (level " << l << ")" << endl;
+                    exit(EXIT_FAILURE);
+                }
+                flat[node] = levels[l][flat[node]];
+            }
+            write_at(table[l].flat_pos, flat.data(), flat.size() * sizeof(int));
+        }
+    }
+    foutput.write(zeros, h.file_size - cur);
+}
@@ -0,0 +1,109 @@
+// File: hierarchy_tree.h
+// -- community tree (text and binary formats) header file
+//-----------------------------------------------------------------------------
+// Community detection
+// Copyright (C) 2020 Mate Soos
+//
+// This file is part of Louvain algorithm.
+//
+// Louvain algorithm is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Louvain algorithm is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Louvain algorithm.  If not, see <http://www.gnu.org/licenses/>.
+//-----------------------------------------------------------------------------
+// see README.txt for more details
+
+#ifndef LOUVAIN_HIERARCHYTREE_H
+#define LOUVAIN_HIERARCHYTREE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "mapped_file.h"
+
+// the community tree gives, for each level l, the community in level l + 1
+// of each node of level l (the nodes of level 0 are the nodes of the graph)
+//
+// text format: one "node community" line per node, level after level (a
+// level starts at node 0), as written by comml-louvain -l -1
+//
+// binary format: a TreeFileHeader, followed by a table of nb_levels
+// TreeLevel entries at table_pos, then the arrays of the levels (4 bytes per
+// node), aligned on TREE_ALIGN bytes from the start of the file:
+//    level_pos: community of each node of the level in the next one
+//    flat_pos: if not 0, community in the next level of each node of the
+//       graph (the levels 0 .. l applied one after the other)
+// any level can then be read directly from the mapped file
+#define TREE_MAGIC "COMMLTR1"
+#define TREE_VERSION 1
+#define TREE_BYTE_ORDER 0x01020304U
+#define TREE_ALIGN 64
+
+struct TreeFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t header_size;
+    uint32_t nb_levels;
+    uint64_t table_pos;
+    uint64_t file_size;
+};
+
+struct TreeLevel {
+    uint64_t nb_nodes;
+    uint64_t level_pos;
+    uint64_t flat_pos;
+};
+
+using namespace std;
+
+class HierarchyTree
+{
+   public:
+    int nb_levels;
+
+    HierarchyTree();
+
+    // reads a tree in either format (exits if the file is not a valid tree)
+    // a binary tree is mapped in memory, a text one is parsed
+    void read(const char *filename);
+
+    // number of nodes of level l
+    unsigned long long level_size(int l);
+
+    // community in level l + 1 of each node of level l
+    const int *level(int l);
+
+    // community of each node of the graph in level l (0 is the graph itself,
+    // so the levels 0 .. l - 1 are applied): read from the file if it has the
+    // flattened arrays, computed in buf otherwise
+    const int *communities(int l, vector<int>& buf);
+
+   private:
+    HierarchyTree(const HierarchyTree &);
+    HierarchyTree &operator=(const HierarchyTree &);
+
+    void read_text(const char *filename);
+    void map_binary(const char *filename);
+
+    MappedFile file;
+    const TreeLevel *table;
+    vector<vector<int> > levels;
+};
+
+// return true if the file starts with the binary tree magic
+bool is_tree_binary(const char *filename);
+
+// writes the levels in the binary format, with the flattened arrays if
+// flatten is set
+void write_tree_binary(const char *filename, const vector<vector<int> >& levels, bool flatten);
+
+#endif // LOUVAIN_HIERARCHYTREE_H
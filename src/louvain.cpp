@@ -28,52 +28,175 @@
 // see readme.txt for more details
 
 #include "louvain.h"
+#include <algorithm>
+#include <cstring>
+#include "buffered_writer.h"
+#include "edge_list.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
 
 using namespace std;
 
 Louvain::Louvain(int nbp, long double epsq, Quality* q, MTRand& _mtrand) :
     mtrand(_mtrand)
+{
+    nb_pass = nbp;
+    eps_impr = epsq;
+
+    reset(q);
+}
+
+void Louvain::reset(Quality* q)
 {
     qual = q;
 
-    neigh_weight.resize(qual->size, -1);
+    neigh_weight.assign(qual->size, -1);
     neigh_pos.resize(qual->size);
     neigh_last = 0;
+    active.clear();
+    stop = function<bool()>();
+    stopped = false;
+    pass_done = function<void(int, int, long double)>();
+    level_passes = 0;
+    level_moves = 0;
+
+    init_hyper();
+}
 
-    nb_pass = nbp;
-    eps_impr = epsq;
+void Louvain::init_hyper()
+{
+    GraphBin& g = qual->g;
+    if (g.nb_hyper > 0) {
+        hyper_comms.resize(g.hyper_nodes.size());
+        hyper_nb_comms.assign(g.nb_hyper, 0);
+        for (int c = 0; c < g.nb_hyper; c++) {
+            unsigned long long b = g.hyper_start(c);
+            for (unsigned long long i = b; i < g.hyper_offsets[c]; i++) {
+                int comm = qual->n2c[g.hyper_nodes[i]];
+                int j = 0;
+                while (j < hyper_nb_comms[c] && hyper_comms[b + j].first != comm)
+                    j++;
+                if (j == hyper_nb_comms[c])
+                    hyper_comms[b + hyper_nb_comms[c]++] = make_pair(comm, 0);
+                hyper_comms[b + j].second++;
+            }
+        }
+    }
 }
 
-void Louvain::init_partition(char* filename)
+static inline bool is_space(char c)
 {
-    ifstream finput;
-    finput.open(filename, fstream::in);
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
 
-    // read partition
-    while (!finput.eof()) {
-        int node, comm;
-        finput >> node >> comm;
+void Louvain::init_partition(char* filename, bool binary)
+{
+    MappedFile f;
+    if (!f.open(filename)) {
+        cerr << "The file " << filename << " does not exist" << endl;
+        exit(EXIT_FAILURE);
+    }
 
-        if (finput) {
-            int old_comm = qual->n2c[node];
-            neigh_comm(node);
+    // the nodes missing from the file stay in their community
+    vector<int> part(qual->n2c);
+    bool valid = true;
+
+    if (binary) {
+        // the community of the first nodes, 4 bytes each
+        size_t nb = f.size / sizeof(int);
+        valid = (f.size % sizeof(int) == 0 && nb <= (size_t)qual->size);
+        if (valid && nb > 0)
+            memcpy(part.data(), f.data, nb * sizeof(int));
+        for (size_t i = 0; valid && i < nb; i++)
+            valid = (part[i] >= 0 && part[i] < qual->size);
+    } else {
+        // "node community" pairs
+        const char* p = f.data;
+        const char* end = f.data + f.size;
+        while (valid) {
+            while (p < end && is_space(*p))
+                p++;
+            if (p == end)
+                break;
+
+            uint32_t node, comm;
+            valid = scan_node(p, end, node);
+            while (valid && p < end && is_space(*p))
+                p++;
+            valid = valid && scan_node(p, end, comm);
+            valid = valid && node < (uint32_t)qual->size && comm < (uint32_t)qual->size;
+            if (valid)
+                part[node] = comm;
+        }
+    }
 
-            qual->remove(node, old_comm, neigh_weight[old_comm]);
+    if (!valid) {
+        cerr << "The file " << filename << " is not a valid partition of the " << qual->size
+             << " nodes" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    set_partition(part);
+}
+
+void Louvain::set_partition(const vector<int>& part)
+{
+    assert(part.size() == (size_t)qual->size);
+
+    // take every node out of its community, then insert it in its new one
+    // each link inside a community is accounted for half by both its ends
+    // (the communities of the nodes are no longer built one node at a time)
+    vector<long double> inner(qual->size, 0.0L);
+    bool trivial = true;
+    for (int node = 0; trivial && node < qual->size; node++)
+        trivial = (qual->n2c[node] == node);
+    if (!trivial)
+        comm_weights(inner);
+    for (int node = 0; node < qual->size; node++)
+        qual->remove(node, qual->n2c[node], inner[node]);
+
+    qual->n2c = part;
+    init_hyper();
+
+    comm_weights(inner);
+    for (int node = 0; node < qual->size; node++)
+        qual->insert(node, part[node], inner[node]);
+}
 
-            int i = 0;
-            for (i = 0; i < neigh_last; i++) {
-                int best_comm = neigh_pos[i];
-                long double best_nblinks = neigh_weight[neigh_pos[i]];
-                if (best_comm == comm) {
-                    qual->insert(node, best_comm, best_nblinks);
-                    break;
+void Louvain::comm_weights(vector<long double>& inner)
+{
+    GraphBin& g = qual->g;
+    const vector<int>& n2c = qual->n2c;
+
+    auto sweep = [&](int first, int last) {
+        for (int node = first; node < last; node++) {
+            int comm = n2c[node];
+            long double d = 0.0L;
+            g.for_each_plain_neighbor(node, [&](int neigh, long double neigh_w) {
+                if (neigh != node && n2c[neigh] == comm)
+                    d += neigh_w;
+            });
+            g.for_each_hyperedge(node, [&](int c) {
+                unsigned long long b = g.hyper_start(c);
+                for (int j = 0; j < hyper_nb_comms[c]; j++) {
+                    if (hyper_comms[b + j].first == comm)
+                        d += g.hyper_w[c] * (long double)(hyper_comms[b + j].second - 1);
                 }
-            }
-            if (i == neigh_last)
-                qual->insert(node, comm, 0);
+            });
+            inner[node] = d / 2.0L;
         }
-    }
-    finput.close();
+    };
+
+    // a single thread for small graphs
+    unsigned nb_threads = ThreadPool::shared().max_threads();
+    unsigned long long nb_links = (unsigned long long)g.nb_links + (unsigned long long)qual->size;
+    nb_threads = (unsigned)min((unsigned long long)nb_threads, nb_links / PARALLEL_MIN_LINKS + 1);
+
+    ThreadPool::shared().run_parallel(nb_threads, [&](size_t t) {
+        int first = (int)((long long)qual->size * t / nb_threads);
+        int last = (int)((long long)qual->size * (t + 1) / nb_threads);
+        sweep(first, last);
+    });
 }
 
 void Louvain::neigh_comm(int node)
@@ -83,17 +206,12 @@ void Louvain::neigh_comm(int node)
 
     neigh_last = 0;
 
-    pair<vector<int>::iterator, vector<long double>::iterator> p = (qual->g).neighbors(node);
-    int deg = (qual->g).nb_neighbors(node);
-
     neigh_pos[0] = qual->n2c[node];
     neigh_weight[neigh_pos[0]] = 0;
     neigh_last = 1;
 
-    for (int i = 0; i < deg; i++) {
-        int neigh = *(p.first + i);
+    (qual->g).for_each_plain_neighbor(node, [&](int neigh, long double neigh_w) {
         int neigh_comm = qual->n2c[neigh];
-        long double neigh_w = ((qual->g).weights.size() == 0) ? 1.0L : *(p.second + i);
 
         if (neigh != node) {
             if (neigh_weight[neigh_comm] == -1) {
@@ -102,9 +220,54 @@ void Louvain::neigh_comm(int node)
             }
             neigh_weight[neigh_comm] += neigh_w;
         }
+    });
+
+    // each hyperedge links node to all its other nodes, count them by community
+    GraphBin& g = qual->g;
+    if (g.nb_hyper > 0) {
+        int node_comm = qual->n2c[node];
+        g.for_each_hyperedge(node, [&](int c) {
+            unsigned long long b = g.hyper_start(c);
+            for (int j = 0; j < hyper_nb_comms[c]; j++) {
+                int comm = hyper_comms[b + j].first;
+                int nb = hyper_comms[b + j].second - ((comm == node_comm) ? 1 : 0);
+                if (nb == 0)
+                    continue;
+                if (neigh_weight[comm] == -1) {
+                    neigh_weight[comm] = 0.0L;
+                    neigh_pos[neigh_last++] = comm;
+                }
+                neigh_weight[comm] += g.hyper_w[c] * (long double)nb;
+            }
+        });
     }
 }
 
+void Louvain::move_hyper(int node, int old_comm, int new_comm)
+{
+    GraphBin& g = qual->g;
+    if (g.nb_hyper == 0)
+        return;
+
+    g.for_each_hyperedge(node, [&](int c) {
+        pair<int, int> *comms = &hyper_comms[g.hyper_start(c)];
+        int& nb = hyper_nb_comms[c];
+
+        int j = 0;
+        while (comms[j].first != old_comm)
+            j++;
+        if (--comms[j].second == 0)
+            comms[j] = comms[--nb];
+
+        j = 0;
+        while (j < nb && comms[j].first != new_comm)
+            j++;
+        if (j == nb)
+            comms[nb++] = make_pair(new_comm, 0);
+        comms[j].second++;
+    });
+}
+
 void Louvain::partition2graph()
 {
     vector<int> renumber(qual->size, -1);
@@ -117,14 +280,14 @@ void Louvain::partition2graph()
         if (renumber[i] != -1)
             renumber[i] = end++;
 
+    BufferedWriter out(cout);
     for (int i = 0; i < qual->size; i++) {
-        pair<vector<int>::iterator, vector<long double>::iterator> p = (qual->g).neighbors(i);
-
-        int deg = (qual->g).nb_neighbors(i);
-        for (int j = 0; j < deg; j++) {
-            int neigh = *(p.first + j);
-            cout << renumber[qual->n2c[i]] << " " << renumber[qual->n2c[neigh]] << endl;
-        }
+        (qual->g).for_each_neighbor(i, [&](int neigh, long double) {
+            out.put_int(renumber[qual->n2c[i]]);
+            out.put_char(' ');
+            out.put_int(renumber[qual->n2c[neigh]]);
+            out.put_char('\n');
+        });
     }
 }
 
@@ -140,81 +303,134 @@ void Louvain::display_partition(vector<int>* level)
         if (renumber[i] != -1)
             renumber[i] = end++;
 
-    for (int i = 0; i < qual->size; i++) {
-        if (level) {
-            level->push_back(renumber[qual->n2c[i]]);
-        } else {
-            cout << i << " " << renumber[qual->n2c[i]] << endl;
-        }
-    }
+    vector<int> part(qual->size);
+    for (int i = 0; i < qual->size; i++)
+        part[i] = renumber[qual->n2c[i]];
+
+    if (level)
+        level->insert(level->end(), part.begin(), part.end());
+    else
+        write_partition(cout, part.data(), part.size());
 }
 
 GraphBin Louvain::partition2graph_binary()
 {
+    GraphBin g2;
+    partition2graph_binary(g2);
+    return g2;
+}
+
+void Louvain::partition2graph_binary(GraphBin& g2)
+{
+    assert(&g2 != &qual->g);
+
     // Renumber communities
-    vector<int> renumber(qual->size, -1);
+    comm_renumber.assign(qual->size, -1);
     for (int node = 0; node < qual->size; node++)
-        renumber[qual->n2c[node]]++;
+        comm_renumber[qual->n2c[node]]++;
 
     int last = 0;
     for (int i = 0; i < qual->size; i++) {
-        if (renumber[i] != -1)
-            renumber[i] = last++;
+        if (comm_renumber[i] != -1)
+            comm_renumber[i] = last++;
     }
 
-    // Compute communities
-    vector<vector<int> > comm_nodes(last);
-    vector<int> comm_weight(last, 0);
+    // Compute communities: the nodes of comm are
+    // comm_nodes[comm_start[comm] .. comm_start[comm + 1]), in increasing order
+    comm_start.assign(last + 1, 0);
+    comm_nodes.resize(qual->size);
+    comm_weight.assign(last, 0);
 
     for (int node = 0; node < (qual->size); node++) {
-        comm_nodes[renumber[qual->n2c[node]]].push_back(node);
-        comm_weight[renumber[qual->n2c[node]]] += (qual->g).nodes_w[node];
+        comm_start[comm_renumber[qual->n2c[node]] + 1]++;
+        comm_weight[comm_renumber[qual->n2c[node]]] += (qual->g).nodes_w[node];
     }
+    for (int comm = 0; comm < last; comm++)
+        comm_start[comm + 1] += comm_start[comm];
 
-    // Compute weighted graph
-    GraphBin g2;
-    int nbc = comm_nodes.size();
+    comm_pos.assign(comm_start.begin(), comm_start.end() - 1);
+    for (int node = 0; node < (qual->size); node++)
+        comm_nodes[comm_pos[comm_renumber[qual->n2c[node]]]++] = node;
 
-    g2.nb_nodes = comm_nodes.size();
-    g2.degrees.resize(nbc);
-    g2.nodes_w.resize(nbc);
+    // the weight to each neighbor community is summed in neigh_weight, as in
+    // neigh_comm()
+    for (int i = 0; i < neigh_last; i++)
+        neigh_weight[neigh_pos[i]] = -1;
+    neigh_last = 0;
+
+    // Compute weighted graph
+    GraphBin& g = qual->g;
+    hyper_seen.assign(g.nb_hyper, -1);
+    int nbc = last;
+
+    // g2 is either new or a graph of communities made here before
+    g2.nb_nodes = nbc;
+    g2.nb_links = 0ULL;
+    g2.total_weight = 0.0L;
+    g2.sum_nodes_w = 0;
+    comm_degrees.resize(nbc);
+    g2.nodes_w.assign(nbc, 0);
+    g2.links.clear();
+    g2.weights.clear();
 
     for (int comm = 0; comm < nbc; comm++) {
-        map<int, long double> m;
-        map<int, long double>::iterator it;
+        g2.assign_weight(comm, comm_weight[comm]);
 
-        int size_c = comm_nodes[comm].size();
+        for (int node = comm_start[comm]; node < comm_start[comm + 1]; node++) {
+            (qual->g).for_each_plain_neighbor(comm_nodes[node], [&](int neigh, long double neigh_w) {
+                int neigh_comm = comm_renumber[qual->n2c[neigh]];
 
-        g2.assign_weight(comm, comm_weight[comm]);
+                if (neigh_weight[neigh_comm] == -1) {
+                    neigh_weight[neigh_comm] = 0.0L;
+                    neigh_pos[neigh_last++] = neigh_comm;
+                }
+                neigh_weight[neigh_comm] += neigh_w;
+            });
+        }
 
-        for (int node = 0; node < size_c; node++) {
-            pair<vector<int>::iterator, vector<long double>::iterator> p =
-                (qual->g).neighbors(comm_nodes[comm][node]);
-            int deg = (qual->g).nb_neighbors(comm_nodes[comm][node]);
-            for (int i = 0; i < deg; i++) {
-                int neigh = *(p.first + i);
-                int neigh_comm = renumber[qual->n2c[neigh]];
-                long double neigh_weight = ((qual->g).weights.size() == 0) ? 1.0L : *(p.second + i);
-
-                it = m.find(neigh_comm);
-                if (it == m.end())
-                    m.insert(make_pair(neigh_comm, neigh_weight));
-                else
-                    it->second += neigh_weight;
-            }
+        // the clique of a hyperedge with cnt nodes in comm and cnt2 in comm2
+        // has cnt * cnt2 edges between them, cnt * (cnt - 1) inside comm
+        for (int node = comm_start[comm]; node < comm_start[comm + 1]; node++) {
+            g.for_each_hyperedge(comm_nodes[node], [&](int c) {
+                if (hyper_seen[c] == comm)
+                    return;
+                hyper_seen[c] = comm;
+
+                unsigned long long b = g.hyper_start(c);
+                long double cnt = 0.0L;
+                for (int j = 0; j < hyper_nb_comms[c]; j++) {
+                    if (comm_renumber[hyper_comms[b + j].first] == comm)
+                        cnt = (long double)hyper_comms[b + j].second;
+                }
+                for (int j = 0; j < hyper_nb_comms[c]; j++) {
+                    int neigh_comm = comm_renumber[hyper_comms[b + j].first];
+                    long double cnt2 = (long double)hyper_comms[b + j].second;
+                    if (neigh_comm == comm)
+                        cnt2 -= 1.0L;
+                    if (cnt2 == 0.0L)
+                        continue;
+                    if (neigh_weight[neigh_comm] == -1) {
+                        neigh_weight[neigh_comm] = 0.0L;
+                        neigh_pos[neigh_last++] = neigh_comm;
+                    }
+                    neigh_weight[neigh_comm] += g.hyper_w[c] * cnt * cnt2;
+                }
+            });
         }
 
-        g2.degrees[comm] = (comm == 0) ? m.size() : g2.degrees[comm - 1] + m.size();
-        g2.nb_links += m.size();
+        comm_degrees[comm] = (comm == 0) ? neigh_last : comm_degrees[comm - 1] + neigh_last;
+        g2.nb_links += neigh_last;
 
-        for (it = m.begin(); it != m.end(); it++) {
-            g2.total_weight += it->second;
-            g2.links.push_back(it->first);
-            g2.weights.push_back(it->second);
+        sort(neigh_pos.begin(), neigh_pos.begin() + neigh_last);
+        for (int i = 0; i < neigh_last; i++) {
+            g2.total_weight += neigh_weight[neigh_pos[i]];
+            g2.links.push_back(neigh_pos[i]);
+            g2.weights.push_back(neigh_weight[neigh_pos[i]]);
+            neigh_weight[neigh_pos[i]] = -1;
         }
+        neigh_last = 0;
     }
-
-    return g2;
+    g2.set_offsets(comm_degrees);
 }
 
 bool Louvain::one_level()
@@ -224,6 +440,7 @@ bool Louvain::one_level()
     int nb_pass_done = 0;
     long double new_qual = qual->quality();
     long double cur_qual = new_qual;
+    bool restricted = !active.empty();
 
     vector<int> random_order(qual->size);
     for (int i = 0; i < qual->size; i++)
@@ -246,7 +463,16 @@ bool Louvain::one_level()
 
         // for each node: remove the node from its community and insert it in the best community
         for (int node_tmp = 0; node_tmp < qual->size; node_tmp++) {
+            if (stop && node_tmp % STOP_CHECK_NODES == 0 && stop()) {
+                stopped = true;
+                break;
+            }
             int node = random_order[node_tmp];
+            if (restricted) {
+                if (!active[node])
+                    continue;
+                active[node] = 0;
+            }
             int node_comm = qual->n2c[node];
             long double w_degree = (qual->g).weighted_degree(node);
 
@@ -273,16 +499,24 @@ bool Louvain::one_level()
             // insert node in the nearest community
             qual->insert(node, best_comm, best_nblinks);
 
-            if (best_comm != node_comm)
+            if (best_comm != node_comm) {
+                move_hyper(node, node_comm, best_comm);
                 nb_moves++;
+                if (restricted)
+                    (qual->g).for_each_neighbor(node, [&](int neigh, long double) { active[neigh] = 1; });
+            }
         }
 
         new_qual = qual->quality();
+        level_passes = nb_pass_done;
+        level_moves += nb_moves;
+        if (pass_done)
+            pass_done(nb_pass_done, nb_moves, new_qual);
 
         if (nb_moves > 0)
             improvement = true;
 
-    } while (nb_moves > 0 && new_qual - cur_qual > eps_impr);
+    } while (nb_moves > 0 && new_qual - cur_qual > eps_impr && !stopped);
 
     return improvement;
 }
@@ -33,6 +33,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <map>
@@ -42,6 +43,13 @@
 #include "quality.h"
 #include "MersenneTwister.h"
 
+// below this number of links, the sweeps over the graph are not worth
+// more than one thread
+#define PARALLEL_MIN_LINKS (1ULL << 16)
+
+// one_level() calls stop() once every that many nodes
+#define STOP_CHECK_NODES 4096
+
 using namespace std;
 
 class Louvain
@@ -51,6 +59,36 @@ class Louvain
     vector<int> neigh_pos;
     int neigh_last;
 
+    // for each hyperedge c of the graph, the communities of its nodes with
+    // the number of its nodes in each: hyper_nb_comms[c] (community, count)
+    // pairs, starting at hyper_comms[g.hyper_start(c)]
+    vector<pair<int, int> > hyper_comms;
+    vector<int> hyper_nb_comms;
+
+    // if not empty, one_level only visits the nodes flagged here: a node is
+    // unflagged once visited, and the neighbors of a node that moves are
+    // flagged (to update the communities after a few changes of the graph)
+    vector<char> active;
+
+    // work arrays of partition2graph_binary(), kept from one level to the
+    // next
+    vector<int> comm_renumber, comm_start, comm_nodes, comm_weight, comm_pos;
+    vector<int> hyper_seen;
+    vector<unsigned long long> comm_degrees;
+
+    // if set, one_level() gives up as soon as it returns true and sets
+    // stopped: the partition is the one reached so far
+    function<bool()> stop;
+    bool stopped;
+
+    // if set, called by one_level() at the end of each pass with the number
+    // of the pass (from 1), the number of moves and the quality
+    function<void(int, int, long double)> pass_done;
+
+    // passes done and nodes moved by one_level()
+    int level_passes;
+    long long level_moves;
+
     //Random number generator
     MTRand& mtrand;
 
@@ -71,13 +109,32 @@ class Louvain
     // type defined the weighted/unweighted status of the graph file
     Louvain(int nb_pass, long double eps_impr, Quality* q, MTRand& mtrand);
 
+    // starts again on q, with each node alone and neither stop nor
+    // pass_done, the work arrays keep their memory
+    void reset(Quality* q);
+
     // initiliazes the partition with something else than all nodes alone
-    void init_partition(char* filename_part);
+    // the file holds "node community" pairs, or (binary) the community of
+    // each node on 4 bytes, as written by write_partition()
+    void init_partition(char* filename_part, bool binary = false);
+
+    // moves every node to its community in part (one per node), the
+    // communities are rebuilt in a single sweep over the graph
+    void set_partition(const vector<int>& part);
+
+    // weight between each node and the other nodes of its community, halved
+    void comm_weights(vector<long double>& inner);
+
+    // counts the nodes of each hyperedge by community (see hyper_comms)
+    void init_hyper();
 
     // compute the set of neighboring communities of node
     // for each community, gives the number of links from node to comm
     void neigh_comm(int node);
 
+    // update hyper_comms after node went from old_comm to new_comm
+    void move_hyper(int node, int old_comm, int new_comm);
+
     // displays the graph of communities as computed by one_level
     void partition2graph();
 
@@ -87,6 +144,10 @@ class Louvain
     // generates the binary graph of communities as computed by one_level
     GraphBin partition2graph_binary();
 
+    // the same in g2, which must not be the graph of qual: g2 is either new
+    // or made by this function before, its arrays keep their memory
+    void partition2graph_binary(GraphBin& g2);
+
     // compute communities of the graph for one level
     // return true if some nodes have been moved
     bool one_level();
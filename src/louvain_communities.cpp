@@ -26,8 +26,16 @@
 
 #include "louvain_communities.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <unordered_map>
 #include <unistd.h>
+#include "cnf_vig.h"
 #include "graph_binary.h"
 #include "graph_plain.h"
 #include "louvain.h"
@@ -40,36 +48,77 @@
 #include "modularity.h"
 #include "owzad.h"
 #include "shimalik.h"
+#include "thread_pool.h"
 #include "zahn.h"
 #include "GitSHA1.h"
 
 namespace LouvainC {
 
+//the quality measure and its parameters, some of them computed on the graph
+//of level 0 (see weight_graph())
+struct QualityParams {
+    int id_qual = 0;
+    long double max_w = 1.0L;
+    long double alpha = 0.5L;
+    int kmin = 1;
+    long double sum_se = 0.0L;
+    long double sum_sq = 0.0L;
+};
+
+//start of a run and its deadline (only used with a time limit)
+struct RunClock {
+    chrono::steady_clock::time_point start;
+    chrono::steady_clock::time_point deadline;
+};
+
 struct PrivateData {
     PrivateData()
     {
-        unsigned seed = 0;
         mtrand.seed(seed);
     }
-    ~PrivateData()
-    {
-        delete q;
-    }
     GraphPlain gplain;
-    unsigned short nb_calls = 0;
     long double precision = 0.000001L;
     uint32_t verbosity = 0;
     vector<vector<int>> levels;
+    unsigned seed = 0;
     MTRand mtrand;
 
+    //community of each node in the last level, and number of communities
+    //of each level, set once the levels are computed
+    vector<int> n2c;
+    vector<unsigned> nb_comms;
+
     //quality measure
-    Quality *q = NULL;
-    int id_qual = 0;
-    long double max_w = 1.0L;
-    long double alpha = 0.5L;
-    int kmin = 1;
-    long double sum_se = 0.0L;
-    long double sum_sq = 0.0L;
+    QualityParams qp;
+
+    //input graph storage
+    bool compressed = false;
+    int weight_storage = WEIGHTS_LONG_DOUBLE;
+
+    //input contract
+    bool trusted_input = false;
+    unsigned trusted_checks = 0;
+
+    //endpoints of the edges changed since the last run (see update())
+    vector<unsigned> touched;
+
+    //the arrays of the graph of level 0, given to GraphBin by build_graph()
+    //and taken back after the run (see release_graph())
+    vector<unsigned long long> deg_seq;
+    vector<int> out_links;
+    vector<long double> out_w;
+
+    //time budget of a run (0: none), cancel flag, whether the last run was
+    //stopped by one of them, and the clock of the last run
+    double time_limit = 0.0;
+    const atomic<bool>* cancel = NULL;
+    bool truncated = false;
+    RunClock clock;
+
+    function<void(const Progress&)> progress;
+
+    //statistics of the last run
+    RunStats stats;
 };
 
 DLL_PUBLIC Communities::Communities()
@@ -84,195 +133,967 @@ DLL_PUBLIC Communities::~Communities()
 
 DLL_PUBLIC void Communities::set_quality_type(unsigned id)
 {
-    data->id_qual = id;
+    data->qp.id_qual = id;
+}
+
+DLL_PUBLIC void Communities::clear()
+{
+    data->gplain.clear();
+    data->touched.clear();
+    data->levels.clear();
+    data->n2c.clear();
+    data->nb_comms.clear();
+    data->truncated = false;
+    data->stats = RunStats();
+    data->mtrand.seed(data->seed);
+}
+
+DLL_PUBLIC void Communities::set_time_limit(double seconds)
+{
+    data->time_limit = seconds;
+}
+
+DLL_PUBLIC void Communities::set_cancel_flag(const std::atomic<bool>* flag)
+{
+    data->cancel = flag;
+}
+
+DLL_PUBLIC bool Communities::is_truncated()
+{
+    return data->truncated;
+}
+
+DLL_PUBLIC void Communities::set_progress_callback(std::function<void(const Progress&)> f)
+{
+    data->progress = f;
+}
+
+DLL_PUBLIC RunStats Communities::get_stats()
+{
+    return data->stats;
 }
 
 DLL_PUBLIC void Communities::set_random_seed(unsigned seed)
 {
+    data->seed = seed;
     data->mtrand.seed(seed);
 }
 
+DLL_PUBLIC void Communities::set_half_storage(bool half)
+{
+    data->gplain.set_half(half);
+}
+
+DLL_PUBLIC void Communities::set_compressed_storage(bool compressed)
+{
+    data->compressed = compressed;
+}
+
+DLL_PUBLIC void Communities::set_weight_storage(unsigned storage)
+{
+    data->weight_storage = (storage <= WEIGHTS_U8) ? (int)storage : WEIGHTS_LONG_DOUBLE;
+}
+
+DLL_PUBLIC void Communities::set_trusted_input(bool trusted, unsigned nb_checks)
+{
+    data->trusted_input = trusted;
+    data->trusted_checks = nb_checks;
+}
+
+//the ends of a changed edge, for the next update(); nothing is recorded
+//before the first run, which starts from the whole graph anyway
+static void touch(PrivateData* data, unsigned src, unsigned dst)
+{
+    if (data->levels.empty())
+        return;
+    data->touched.push_back(src);
+    data->touched.push_back(dst);
+}
+
 DLL_PUBLIC void Communities::add_edge(unsigned int src, unsigned int dst, long double weight)
 {
     data->gplain.add_edge(src, dst, weight);
+    touch(data, src, dst);
+}
+
+DLL_PUBLIC void Communities::remove_edge(unsigned int src, unsigned int dst)
+{
+    data->gplain.remove_edge(src, dst);
+    touch(data, src, dst);
+}
+
+DLL_PUBLIC void Communities::set_edge_weight(unsigned int src, unsigned int dst, long double weight)
+{
+    data->gplain.remove_edge(src, dst);
+    add_edge(src, dst, weight);
+}
+
+DLL_PUBLIC bool Communities::add_cnf(const char* filename, unsigned nb_threads, bool as_hyperedges)
+{
+    string err;
+    if (!read_cnf_vig(filename, nb_threads, data->gplain, err, as_hyperedges)) {
+        if (data->verbosity)
+            cerr << err << endl;
+        return false;
+    }
+    return true;
+}
+
+DLL_PUBLIC void Communities::add_hyperedge(const std::vector<unsigned>& nodes, long double weight)
+{
+    vector<uint32_t> v(nodes.begin(), nodes.end());
+    sort(v.begin(), v.end());
+    v.erase(unique(v.begin(), v.end()), v.end());
+    if (v.size() < 2)
+        return;
+    data->gplain.add_hyperedge(&v[0], &v[0] + v.size(), weight);
 }
 
 DLL_PUBLIC void Communities::set_sum_se(long double sum_se)
 {
-    assert(data->id_qual == 4);
-    data->sum_se = sum_se;
+    assert(data->qp.id_qual == 4);
+    data->qp.sum_se = sum_se;
 }
 
 DLL_PUBLIC void Communities::set_kmin(int kmin)
 {
-    assert(data->id_qual == 8);
-    data->kmin = kmin;
+    assert(data->qp.id_qual == 8);
+    data->qp.kmin = kmin;
 }
 
 DLL_PUBLIC void Communities::set_max_w(long double max_w)
 {
     assert(
-        data->id_qual == 1 ||
-        data->id_qual == 2 ||
-        data->id_qual == 3 ||
-        data->id_qual == 7 ||
-        data->id_qual == 9
+        data->qp.id_qual == 1 ||
+        data->qp.id_qual == 2 ||
+        data->qp.id_qual == 3 ||
+        data->qp.id_qual == 7 ||
+        data->qp.id_qual == 9
     );
-    data->max_w = max_w;
+    data->qp.max_w = max_w;
 }
 
 DLL_PUBLIC void Communities::set_alpha(long double alpha)
 {
-    assert(data->id_qual == 2);
-    data->alpha = alpha;
+    assert(data->qp.id_qual == 2);
+    data->qp.alpha = alpha;
 }
 
 
-void init_quality(PrivateData* data, GraphBin* g)
+//the parameters computed once on the graph of level 0, and kept for the
+//upper levels
+static void weight_graph(QualityParams& p, GraphBin* g)
 {
-    delete data->q;
-    switch (data->id_qual) {
-        case 0:
-            data->q = new Modularity(*g);
-            break;
+    switch (p.id_qual) {
         case 1:
-            if (data->nb_calls == 0)
-                data->max_w = g->max_weight();
-            data->q = new Zahn(*g, data->max_w);
+        case 3:
+        case 9:
+            p.max_w = g->max_weight();
             break;
         case 2:
-            if (data->nb_calls == 0)
-                data->max_w = g->max_weight();
-            if (data->alpha <= 0.0L || data->alpha >= 1.0L)
-                data->alpha = 0.5L;
-            data->q = new OwZad(*g, data->alpha, data->max_w);
-            break;
-        case 3:
-            if (data->nb_calls == 0)
-                data->max_w = g->max_weight();
-            data->q = new Goldberg(*g, data->max_w);
+            p.max_w = g->max_weight();
+            if (p.alpha <= 0.0L || p.alpha >= 1.0L)
+                p.alpha = 0.5L;
             break;
         case 4:
-            if (data->nb_calls == 0) {
-                g->add_selfloops();
-                data->sum_se = CondorA::graph_weighting(g);
-            }
-            data->q = new CondorA(*g, data->sum_se);
+            g->add_selfloops();
+            p.sum_se = CondorA::graph_weighting(g);
             break;
-        case 5:
-            data->q = new DevInd(*g);
+        case 7:
+            p.max_w = g->max_weight();
+            p.sum_sq = DP::graph_weighting(g);
             break;
+        case 8:
+            if (p.kmin < 1)
+                p.kmin = 1;
+            break;
+    }
+}
+
+//only reads p, several runs can call it at once
+static Quality* new_quality(const QualityParams& p, GraphBin& g)
+{
+    switch (p.id_qual) {
+        case 0:
+            return new Modularity(g);
+        case 1:
+            return new Zahn(g, p.max_w);
+        case 2:
+            return new OwZad(g, p.alpha, p.max_w);
+        case 3:
+            return new Goldberg(g, p.max_w);
+        case 4:
+            return new CondorA(g, p.sum_se);
+        case 5:
+            return new DevInd(g);
         case 6:
-            data->q = new DevUni(*g);
+            return new DevUni(g);
+        case 7:
+            return new DP(g, p.sum_sq, p.max_w);
+        case 8:
+            return new ShiMalik(g, p.kmin);
+        case 9:
+            return new BalMod(g, p.max_w);
+        default:
+            return new Modularity(g);
+    }
+}
+
+//the criteria only relying on the weighted degrees, the selfloops and the
+//weight of the links between a node and each community
+static bool works_on_hyperedges(int id_qual)
+{
+    return id_qual == 0 || id_qual == 5 || id_qual == 6 || id_qual == 8;
+}
+
+//q, made by new_quality() for p.id_qual, back to each node of its graph
+//alone, with the parameters of p (some of them depend on the graph)
+static void reset_quality(Quality* q, const QualityParams& p)
+{
+    switch (p.id_qual) {
+        case 1:
+            static_cast<Zahn*>(q)->max = p.max_w;
+            break;
+        case 2:
+            static_cast<OwZad*>(q)->alpha = p.alpha;
+            static_cast<OwZad*>(q)->max = p.max_w;
+            break;
+        case 3:
+            static_cast<Goldberg*>(q)->max = p.max_w;
+            break;
+        case 4:
+            static_cast<CondorA*>(q)->sum_se = p.sum_se;
             break;
         case 7:
-            if (data->nb_calls == 0) {
-                data->max_w = g->max_weight();
-                data->sum_sq = DP::graph_weighting(g);
-            }
-            data->q = new DP(*g, data->sum_sq, data->max_w);
+            static_cast<DP*>(q)->sum_sq = p.sum_sq;
+            static_cast<DP*>(q)->max = p.max_w;
             break;
         case 8:
-            if (data->kmin < 1)
-                data->kmin = 1;
-            data->q = new ShiMalik(*g, data->kmin);
+            static_cast<ShiMalik*>(q)->kmin = p.kmin;
             break;
         case 9:
-            if (data->nb_calls == 0)
-                data->max_w = g->max_weight();
-            data->q = new BalMod(*g, data->max_w);
-            break;
-        default:
-            data->q = new Modularity(*g);
+            static_cast<BalMod*>(q)->max = p.max_w;
             break;
     }
+    q->reset();
 }
 
-DLL_PUBLIC void Communities::calculate(bool weighted)
+//the objects of run(), kept from one run to the next by the callers running
+//many of them: the graphs of the levels after the first alternate between
+//next[0] and next[1], qual[0] is the quality of the graph of level 0 and
+//qual[1 + i] the one of next[i]
+struct RunScratch {
+    GraphBin next[2];
+    Quality* qual[3];
+    Louvain* c;
+
+    RunScratch() : qual(), c(NULL)
+    {
+    }
+    ~RunScratch()
+    {
+        delete c;
+        for (int i = 0; i < 3; i++)
+            delete qual[i];
+    }
+
+   private:
+    RunScratch(const RunScratch&);
+    RunScratch& operator=(const RunScratch&);
+};
+
+//the quality of g, reusing s.qual[i] if it was made for g
+static Quality* scratch_quality(RunScratch& s, int i, const QualityParams& qp, GraphBin& g)
 {
-    data->gplain.clean(weighted ? WEIGHTED : UNWEIGHTED);
-    vector<unsigned long long> deg_seq;
-    vector<int> out_links;
-    vector<long double> out_w;
-    data->gplain.binary_to_mem(deg_seq, out_links, out_w, weighted ? WEIGHTED : UNWEIGHTED);
-    GraphBin g(deg_seq, out_links, out_w, weighted ? WEIGHTED : UNWEIGHTED);
-    init_quality(data, &g);
-    data->nb_calls++;
+    if (s.qual[i] != NULL && &s.qual[i]->g == &g) {
+        reset_quality(s.qual[i], qp);
+    } else {
+        delete s.qual[i];
+        s.qual[i] = new_quality(qp, g);
+    }
+    return s.qual[i];
+}
+
+//the Louvain object of q, reusing s.c if it draws from mtrand
+static Louvain* scratch_louvain(RunScratch& s, const PrivateData* data, Quality* q, MTRand& mtrand)
+{
+    if (s.c != NULL && &s.c->mtrand == &mtrand) {
+        s.c->reset(q);
+    } else {
+        delete s.c;
+        s.c = new Louvain(-1, data->precision, q, mtrand);
+    }
+    return s.c;
+}
+
+//moves the nodes of level 0 to their initial community, renumbered from 0
+static void init_partition(Louvain* c, const vector<int>& init)
+{
+    vector<int> part(c->qual->size);
+    unordered_map<int, int> renum;
+    int nb = 0;
+    for (int node = 0; node < c->qual->size; node++) {
+        if ((size_t)node < init.size() && init[node] >= 0) {
+            unordered_map<int, int>::iterator it = renum.find(init[node]);
+            if (it == renum.end())
+                it = renum.insert(make_pair(init[node], nb++)).first;
+            part[node] = it->second;
+        } else {
+            part[node] = nb++;
+        }
+    }
+    c->set_partition(part);
+}
+
+//community of each node of level 0 in the last level
+static void flat_mapping(PrivateData* data, vector<int>& n2c)
+{
+    n2c.resize(data->levels.empty() ? 0 : data->levels[0].size());
+    for (unsigned int i = 0; i < n2c.size(); i++)
+        n2c[i] = i;
+
+    for (unsigned l = 0; l < data->levels.size(); l++) {
+        for (unsigned int node = 0; node < n2c.size(); node++)
+            n2c[node] = data->levels[l][n2c[node]];
+    }
+}
+
+//the node -> community mapping at the given level, composed from level 0
+//level < 0 or past the last level means the last level
+static inline int community(PrivateData* data, unsigned node, int level)
+{
+    if (level < 0 || level + 1 >= (int)data->levels.size())
+        return data->n2c[node];
+
+    int c = data->levels[0][node];
+    for (int l = 1; l <= level; l++)
+        c = data->levels[l][c];
+    return c;
+}
+
+static void set_results(PrivateData* data)
+{
+    flat_mapping(data, data->n2c);
+
+    data->nb_comms.resize(data->levels.size());
+    for (unsigned l = 0; l < data->levels.size(); l++) {
+        int nb = 0;
+        for (size_t i = 0; i < data->levels[l].size(); i++)
+            nb = max(nb, data->levels[l][i] + 1);
+        data->nb_comms[l] = nb;
+    }
+}
+
+//level 0 of an update only visits the nodes affected by the changes: the
+//endpoints of the changed edges, the other members of their communities in
+//prev (the last result) and the new nodes
+static void mark_touched(PrivateData* data, Louvain* c, const vector<int>& prev)
+{
+    int size = c->qual->size;
+    c->active.assign(size, 1);
+
+    vector<char> hit(prev.size(), 0);
+    for (size_t i = 0; i < data->touched.size(); i++) {
+        unsigned node = data->touched[i];
+        if (node < prev.size())
+            hit[prev[node]] = 1;
+    }
+    for (size_t node = 0; node < prev.size() && node < (size_t)size; node++)
+        c->active[node] = hit[prev[node]];
+    for (size_t i = 0; i < data->touched.size(); i++) {
+        if (data->touched[i] < (unsigned)size)
+            c->active[data->touched[i]] = 1;
+    }
+}
+
+static double seconds_since(chrono::steady_clock::time_point t)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - t).count();
+}
+
+//a new hierarchy: the graph of level 0 is built from gplain and weighted
+//again
+static void build_graph(PrivateData* data, bool weighted, GraphBin& g)
+{
+    chrono::steady_clock::time_point t = chrono::steady_clock::now();
+
+    data->levels.clear();
+    data->n2c.clear();
+    data->nb_comms.clear();
+
+    if (!data->gplain.hyper_w.empty() && !(weighted && works_on_hyperedges(data->qp.id_qual)))
+        data->gplain.expand_hyperedges();
 
-    if (data->verbosity) {
-        cout << "Computation of communities with the " << data->q->name
+    if (data->trusted_input) {
+        data->gplain.sort_links();
+        if (data->trusted_checks > 0 && !data->gplain.check_clean(data->trusted_checks)) {
+            if (data->verbosity)
+                cout << "Input has duplicate edges, cleaning it" << endl;
+            data->gplain.clean(weighted ? WEIGHTED : UNWEIGHTED);
+        }
+    } else {
+        data->gplain.clean(weighted ? WEIGHTED : UNWEIGHTED);
+    }
+    data->deg_seq.clear();
+    data->out_links.clear();
+    data->out_w.clear();
+    data->gplain.binary_to_mem(data->deg_seq, data->out_links, data->out_w, weighted ? WEIGHTED : UNWEIGHTED);
+    g = GraphBin(data->deg_seq, data->out_links, data->out_w, weighted ? WEIGHTED : UNWEIGHTED, data->gplain.half);
+    if (weighted)
+        g.quantize_weights(data->weight_storage);
+    if (data->compressed && !g.half)
+        g.compress_links();
+    if (!data->gplain.hyper_w.empty()) {
+        vector<unsigned long long> hyper_offsets(data->gplain.hyper_offsets);
+        vector<int> hyper_nodes(data->gplain.hyper_nodes);
+        vector<long double> hyper_w(data->gplain.hyper_w);
+        g.set_hyperedges(hyper_offsets, hyper_nodes, hyper_w);
+    }
+    data->stats.time_graph = seconds_since(t);
+
+    t = chrono::steady_clock::now();
+    weight_graph(data->qp, &g);
+    data->stats.time_weighting = seconds_since(t);
+}
+
+//bytes of the work arrays of c and of next, the graph built from its partition
+static unsigned long long scratch_bytes(Louvain* c, const GraphBin& next)
+{
+    unsigned long long b = 0ULL;
+    b += c->neigh_weight.capacity() * sizeof(long double) + c->neigh_pos.capacity() * sizeof(int);
+    b += c->active.capacity() + c->hyper_comms.capacity() * sizeof(pair<int, int>);
+    b += c->hyper_nb_comms.capacity() * sizeof(int);
+    b += (c->comm_renumber.capacity() + c->comm_start.capacity() + c->comm_nodes.capacity()) * sizeof(int);
+    b += (c->comm_weight.capacity() + c->comm_pos.capacity() + c->hyper_seen.capacity()) * sizeof(int);
+    b += c->comm_degrees.capacity() * sizeof(unsigned long long);
+    //the node order of one_level() and the partition
+    b += 2ULL * c->qual->size * sizeof(int);
+
+    b += next.offsets32.v.capacity() * sizeof(uint32_t) + next.offsets64.v.capacity() * sizeof(unsigned long long);
+    b += next.links.capacity() * sizeof(int) + next.weights.capacity() * sizeof(long double);
+    b += next.nodes_w.capacity() * sizeof(int);
+    return b;
+}
+
+//the time budget starts with each run
+static RunClock new_clock(const PrivateData* data)
+{
+    RunClock clock;
+    clock.start = chrono::steady_clock::now();
+    clock.deadline = clock.start
+        + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(data->time_limit));
+    return clock;
+}
+
+static void start_clock(PrivateData* data)
+{
+    data->truncated = false;
+    data->stats = RunStats();
+    data->clock = new_clock(data);
+}
+
+//the test given to Louvain::stop, empty if there is no budget nor flag
+static function<bool()> stop_function(const PrivateData* data, const RunClock& clock)
+{
+    if (data->time_limit <= 0.0 && data->cancel == NULL)
+        return function<bool()>();
+
+    const atomic<bool>* cancel = data->cancel;
+    bool limited = data->time_limit > 0.0;
+    chrono::steady_clock::time_point deadline = clock.deadline;
+    return [cancel, limited, deadline]() {
+        if (cancel != NULL && cancel->load(memory_order_relaxed))
+            return true;
+        return limited && chrono::steady_clock::now() >= deadline;
+    };
+}
+
+static void release_graph(PrivateData* data, GraphBin& g)
+{
+    data->out_links.swap(g.links);
+    data->out_w.swap(g.weights);
+}
+
+//the levels of one run of the algorithm on g0 (the graph of level 0, only
+//read), returns the final quality
+//with incremental, init is the last result and level 0 starts from the
+//nodes affected by the changes since (see update())
+//the graphs of the next levels, the qualities and the Louvain object are
+//taken from s and left there
+static long double run(
+    PrivateData* data,
+    const QualityParams& qp,
+    GraphBin& g0,
+    MTRand& mtrand,
+    RunScratch& s,
+    vector<vector<int>>& levels,
+    const vector<int>* init,
+    bool incremental,
+    unsigned verbosity,
+    const function<void(const Progress&)>& progress,
+    const RunClock& clock,
+    bool& truncated,
+    RunStats* stats)
+{
+    chrono::steady_clock::time_point t = chrono::steady_clock::now();
+    Quality* q = scratch_quality(s, 0, qp, g0);
+    double time_quality = seconds_since(t);
+    function<bool()> stop = stop_function(data, clock);
+
+    int level = 0;
+    Progress p = Progress();
+    //p is filled by the caller, the rest here
+    auto report = [&](Louvain* c) {
+        p.level = level;
+        p.nb_nodes = c->qual->g.nb_nodes;
+        p.nb_links = c->qual->g.nb_links;
+        p.elapsed = chrono::duration<double>(chrono::steady_clock::now() - clock.start).count();
+        progress(p);
+    };
+
+    if (verbosity) {
+        cout << "Computation of communities with the " << q->name
         << " quality function" << endl;
     }
-    Louvain* c = new Louvain(-1, data->precision, data->q, data->mtrand);
+    Louvain* c = scratch_louvain(s, data, q, mtrand);
+    c->stop = stop;
+    if (init != NULL)
+        init_partition(c, *init);
+    if (incremental)
+        mark_touched(data, c, *init);
 
     bool improvement = true;
 
     long double quality = (c->qual)->quality();
-    long double new_qual;
+    long double new_qual = quality;
 
-    int level = 0;
+    LevelStats ls = LevelStats();
 
+    truncated = false;
     do {
-        if (data->verbosity) {
+        if (level > 0 && stop && stop()) {
+            truncated = true;
+            break;
+        }
+        if (verbosity) {
             cout << "level " << level << ":\n";
             cout << "  network size: " << (c->qual)->g.nb_nodes << " nodes, " << (c->qual)->g.nb_links
                  << " links, " << (c->qual)->g.total_weight << " weight" << endl;
         }
 
+        if (progress) {
+            c->pass_done = [&, c](int pass, int nb_moves, long double pass_qual) {
+                p.pass = pass;
+                p.level_done = false;
+                p.nb_moves = nb_moves;
+                p.quality = pass_qual;
+                report(c);
+            };
+        }
+        t = chrono::steady_clock::now();
         improvement = c->one_level();
         new_qual = (c->qual)->quality();
+        ls.time_moving = seconds_since(t);
+        if (progress) {
+            p.level_done = true;
+            p.nb_moves = c->level_moves;
+            p.quality = new_qual;
+            report(c);
+        }
 
-        data->levels.push_back(vector<int>());
-        c->display_partition(&(data->levels[level]));
+        ls.nb_nodes = c->qual->g.nb_nodes;
+        ls.nb_links = c->qual->g.nb_links;
+        ls.nb_passes = c->level_passes;
+        ls.nb_moves = c->level_moves;
+        ls.quality_before = quality;
+        ls.quality_after = new_qual;
+        ls.time_quality = time_quality;
 
-        g = c->partition2graph_binary();
-        init_quality(data, &g);
-        data->nb_calls++;
+        t = chrono::steady_clock::now();
+        levels.push_back(vector<int>());
+        c->display_partition(&(levels[level]));
 
-        delete c;
-        c = new Louvain(-1, data->precision, data->q, data->mtrand);
+        //the partition reached so far is the last level
+        if (c->stopped) {
+            truncated = true;
+            ls.time_aggregation = seconds_since(t);
+            if (stats != NULL)
+                stats->levels.push_back(ls);
+            break;
+        }
 
-        if (data->verbosity) {
+        GraphBin& g = s.next[level % 2];
+        c->partition2graph_binary(g);
+        ls.time_aggregation = seconds_since(t);
+        if (stats != NULL) {
+            stats->levels.push_back(ls);
+            stats->peak_scratch_bytes = max(stats->peak_scratch_bytes, scratch_bytes(c, g));
+        }
+
+        t = chrono::steady_clock::now();
+        q = scratch_quality(s, 1 + level % 2, qp, g);
+        time_quality = seconds_since(t);
+
+        c->reset(q);
+        c->stop = stop;
+
+        if (verbosity) {
             cout << "  quality increased from " << quality << " to " << new_qual << endl;
         }
 
         quality = new_qual;
         level++;
+
+        //the initial partition is aggregated even if level 0 moved nothing
+        if (init != NULL && level == 1)
+            improvement = true;
     } while (improvement);
-    delete c;
 
-    if (data->verbosity) {
+    if (verbosity) {
+        if (truncated)
+            cout << "Stopped before convergence" << endl;
         cout << "Quality: " << new_qual << endl;
     }
+    return new_qual;
 }
 
+//the concurrent runs report no progress
+static const function<void(const Progress&)> no_progress;
 
-DLL_PUBLIC void Communities::set_precision(long double precision)
+static void calculate(PrivateData* data, bool weighted, const vector<int>* init, bool incremental)
 {
-    data->precision = precision;
+    start_clock(data);
+    GraphBin g;
+    build_graph(data, weighted, g);
+
+    RunScratch s;
+    run(data, data->qp, g, data->mtrand, s, data->levels, init, incremental, data->verbosity, data->progress,
+        data->clock, data->truncated, &data->stats);
+    release_graph(data, g);
+    data->touched.clear();
+    set_results(data);
+
+    data->stats.truncated = data->truncated;
+    data->stats.time_total = seconds_since(data->clock.start);
 }
 
-DLL_PUBLIC std::vector<std::pair<unsigned int, int> > Communities::get_mapping()
+DLL_PUBLIC void Communities::calculate_best_of(unsigned nb_runs, bool weighted, unsigned nb_threads)
 {
-    std::vector<std::pair<unsigned int, int> > ret;
-    vector<int> n2c(data->levels[0].size());
+    if (nb_runs == 0)
+        nb_runs = 1;
+    if (nb_threads == 0)
+        nb_threads = ThreadPool::shared().max_threads();
+    nb_threads = min(nb_threads, nb_runs);
 
-    for (unsigned int i = 0; i < data->levels[0].size(); i++)
-        n2c[i] = i;
+    start_clock(data);
+    GraphBin g;
+    build_graph(data, weighted, g);
+    data->touched.clear();
 
-    for (unsigned l = 0; l < data->levels.size(); l++) {
-        for (unsigned int node = 0; node < data->levels[0].size(); node++) {
-            n2c[node] = data->levels[l][n2c[node]];
+    //run i has its own generator, seeded with seed + i, and its own levels
+    vector<vector<vector<int>>> levels(nb_runs);
+    vector<long double> quality(nb_runs);
+    vector<char> truncated(nb_runs, 0);
+    vector<RunStats> stats(nb_runs);
+    atomic<unsigned> next(0);
+    ThreadPool::shared().run_parallel(nb_threads, [&](size_t) {
+        MTRand mtrand(data->seed);
+        RunScratch s;
+        for (unsigned i = next++; i < nb_runs; i = next++) {
+            mtrand.seed(data->seed + i);
+            bool stopped;
+            quality[i] = run(data, data->qp, g, mtrand, s, levels[i], NULL, false, 0, no_progress, data->clock,
+                             stopped, &stats[i]);
+            truncated[i] = stopped;
+        }
+    });
+
+    unsigned best = 0;
+    for (unsigned i = 0; i < nb_runs; i++) {
+        if (truncated[i])
+            data->truncated = true;
+        if (data->verbosity)
+            cout << "run " << i << " (seed " << data->seed + i << "): quality " << quality[i] << endl;
+        if (quality[i] > quality[best])
+            best = i;
+    }
+    if (data->verbosity)
+        cout << "Quality: " << quality[best] << " (run " << best << ")" << endl;
+
+    release_graph(data, g);
+    data->levels.swap(levels[best]);
+    set_results(data);
+
+    data->stats.levels.swap(stats[best].levels);
+    data->stats.peak_scratch_bytes = stats[best].peak_scratch_bytes;
+    data->stats.truncated = data->truncated;
+    data->stats.time_total = seconds_since(data->clock.start);
+}
+
+//the buffers of a thread of calculate_batch(), kept from one graph to the
+//next: g is the graph of level 0 and s the objects of the levels
+struct Workspace {
+    vector<unsigned long long> deg_seq;
+    vector<unsigned long long> pos;
+    vector<int> links;
+    vector<long double> weights;
+    vector<pair<int, long double> > tmp;
+    vector<vector<int>> levels;
+    QualityParams qp;
+    MTRand mtrand;
+    GraphBin g;
+    RunScratch s;
+};
+
+static bool less_node(const pair<int, long double>& a, const pair<int, long double>& b)
+{
+    return a.first < b.first;
+}
+
+//the graph of level 0, as built by build_graph() from the same edges given
+//to add_edge(): both directions of each edge, the neighbors of a node sorted
+//and the duplicate edges merged (summing their weights in order if weighted)
+static void build_graph(const vector<Edge>& edges, bool weighted, Workspace& ws, GraphBin& g)
+{
+    int nb_nodes = 0;
+    for (size_t i = 0; i < edges.size(); i++)
+        nb_nodes = max(nb_nodes, (int)max(edges[i].src, edges[i].dst) + 1);
+
+    ws.deg_seq.assign(nb_nodes, 0ULL);
+    for (size_t i = 0; i < edges.size(); i++) {
+        ws.deg_seq[edges[i].src]++;
+        if (edges[i].dst != edges[i].src)
+            ws.deg_seq[edges[i].dst]++;
+    }
+    ws.pos.resize(nb_nodes);
+    unsigned long long nb_links = 0ULL;
+    for (int node = 0; node < nb_nodes; node++) {
+        ws.pos[node] = nb_links;
+        nb_links += ws.deg_seq[node];
+    }
+
+    ws.links.resize(nb_links);
+    ws.weights.resize(weighted ? nb_links : 0);
+    for (size_t i = 0; i < edges.size(); i++) {
+        const Edge& e = edges[i];
+        unsigned long long k = ws.pos[e.src]++;
+        ws.links[k] = e.dst;
+        if (weighted)
+            ws.weights[k] = e.weight;
+        if (e.dst != e.src) {
+            k = ws.pos[e.dst]++;
+            ws.links[k] = e.src;
+            if (weighted)
+                ws.weights[k] = e.weight;
         }
     }
 
-    for (unsigned int node = 0; node < data->levels[0].size(); node++) {
-        ret.push_back(std::make_pair(node, n2c[node]));
+    //sort and merge in place, pos[node] is the end of the neighbors of node
+    unsigned long long tot = 0ULL, b = 0ULL;
+    for (int node = 0; node < nb_nodes; node++) {
+        unsigned long long e = ws.pos[node];
+        if (!weighted) {
+            sort(ws.links.begin() + b, ws.links.begin() + e);
+            for (unsigned long long k = b; k < e; k++) {
+                if (k == b || ws.links[k] != ws.links[k - 1])
+                    ws.links[tot++] = ws.links[k];
+            }
+        } else {
+            ws.tmp.clear();
+            for (unsigned long long k = b; k < e; k++)
+                ws.tmp.push_back(make_pair(ws.links[k], ws.weights[k]));
+            stable_sort(ws.tmp.begin(), ws.tmp.end(), less_node);
+
+            unsigned long long first = tot;
+            for (size_t i = 0; i < ws.tmp.size(); i++) {
+                if (tot > first && ws.links[tot - 1] == ws.tmp[i].first) {
+                    ws.weights[tot - 1] += ws.tmp[i].second;
+                } else {
+                    ws.links[tot] = ws.tmp[i].first;
+                    ws.weights[tot] = ws.tmp[i].second;
+                    tot++;
+                }
+            }
+        }
+        ws.deg_seq[node] = tot;
+        b = e;
+    }
+    ws.links.resize(tot);
+    if (weighted)
+        ws.weights.resize(tot);
+
+    //the graph takes the buffers, they are given back after the run
+    g = GraphBin(ws.deg_seq, ws.links, ws.weights, weighted ? WEIGHTED : UNWEIGHTED, false);
+}
+
+DLL_PUBLIC bool Communities::calculate_batch(
+    const std::vector<std::vector<Edge>>& graphs,
+    std::vector<std::vector<int>>& n2c,
+    bool weighted,
+    unsigned nb_threads)
+{
+    if (nb_threads == 0)
+        nb_threads = ThreadPool::shared().max_threads();
+    nb_threads = max(1U, min(nb_threads, (unsigned)graphs.size()));
+
+    //the state of this object is only read
+    RunClock clock = new_clock(data);
+    n2c.resize(graphs.size());
+    vector<Workspace> workspaces(nb_threads);
+    vector<char> truncated(nb_threads, 0);
+    atomic<size_t> next(0);
+    ThreadPool::shared().run_parallel(nb_threads, [&](size_t t) {
+        Workspace& ws = workspaces[t];
+        GraphBin& g = ws.g;
+        for (size_t i = next++; i < graphs.size(); i = next++) {
+            build_graph(graphs[i], weighted, ws, g);
+            ws.qp = data->qp;
+            weight_graph(ws.qp, &g);
+            ws.mtrand.seed(data->seed);
+
+            ws.levels.clear();
+            bool stopped;
+            run(data, ws.qp, g, ws.mtrand, ws.s, ws.levels, NULL, false, 0, no_progress, clock, stopped, NULL);
+            if (stopped)
+                truncated[t] = 1;
+
+            vector<int>& out = n2c[i];
+            out.resize(g.nb_nodes);
+            for (int node = 0; node < g.nb_nodes; node++) {
+                int c = node;
+                for (size_t l = 0; l < ws.levels.size(); l++)
+                    c = ws.levels[l][c];
+                out[node] = c;
+            }
+
+            ws.links.swap(g.links);
+            ws.weights.swap(g.weights);
+        }
+    });
+    for (unsigned t = 0; t < nb_threads; t++) {
+        if (truncated[t])
+            return true;
+    }
+    return false;
+}
+
+DLL_PUBLIC void Communities::calculate(bool weighted)
+{
+    LouvainC::calculate(data, weighted, NULL, false);
+}
+
+DLL_PUBLIC std::future<void> Communities::calculate_async(bool weighted)
+{
+    shared_ptr<packaged_task<void()> > task =
+        make_shared<packaged_task<void()> >([this, weighted]() { calculate(weighted); });
+    future<void> done = task->get_future();
+    ThreadPool::shared().submit([task]() { (*task)(); });
+    return done;
+}
+
+DLL_PUBLIC void Communities::set_max_threads(unsigned nb)
+{
+    ThreadPool::shared().set_max_threads(nb);
+}
+
+DLL_PUBLIC void Communities::calculate(bool weighted, const std::vector<int>& init)
+{
+    LouvainC::calculate(data, weighted, &init, false);
+}
+
+DLL_PUBLIC void Communities::calculate(
+    bool weighted,
+    const std::vector<std::pair<unsigned int, int>>& init)
+{
+    vector<int> part;
+    for (size_t i = 0; i < init.size(); i++) {
+        if (part.size() <= init[i].first)
+            part.resize(init[i].first + 1, -1);
+        part[init[i].first] = init[i].second;
+    }
+    LouvainC::calculate(data, weighted, &part, false);
+}
+
+DLL_PUBLIC void Communities::update(bool weighted)
+{
+    if (data->levels.empty()) {
+        LouvainC::calculate(data, weighted, NULL, false);
+        return;
+    }
+
+    vector<int> prev(data->n2c);
+    LouvainC::calculate(data, weighted, &prev, true);
+}
+
+
+DLL_PUBLIC void Communities::set_precision(long double precision)
+{
+    data->precision = precision;
+}
+
+DLL_PUBLIC std::vector<std::pair<unsigned int, int> > Communities::get_mapping()
+{
+    std::vector<std::pair<unsigned int, int> > ret(data->n2c.size());
+
+    for (unsigned int node = 0; node < data->n2c.size(); node++) {
+        ret[node] = std::make_pair(node, data->n2c[node]);
     }
 
     return ret;
 }
 
+DLL_PUBLIC unsigned Communities::get_nb_nodes()
+{
+    return data->n2c.size();
+}
+
+DLL_PUBLIC unsigned Communities::get_nb_levels()
+{
+    return data->levels.size();
+}
+
+DLL_PUBLIC unsigned Communities::get_nb_communities(int level)
+{
+    if (data->nb_comms.empty())
+        return 0;
+    if (level < 0 || level >= (int)data->nb_comms.size())
+        return data->nb_comms.back();
+    return data->nb_comms[level];
+}
+
+DLL_PUBLIC void Communities::get_mapping(int* n2c, int level)
+{
+    if (level < 0 || level + 1 >= (int)data->levels.size()) {
+        if (!data->n2c.empty())
+            memcpy(n2c, &data->n2c[0], data->n2c.size() * sizeof(int));
+        return;
+    }
+
+    for (unsigned node = 0; node < data->n2c.size(); node++)
+        n2c[node] = community(data, node, level);
+}
+
+DLL_PUBLIC void Communities::get_members(unsigned* offsets, unsigned* members, int level)
+{
+    unsigned nb_comms = get_nb_communities(level);
+    unsigned nb_nodes = data->n2c.size();
+
+    //counting sort on the community, offsets[c + 1] counts the members of c
+    for (unsigned c = 0; c <= nb_comms; c++)
+        offsets[c] = 0;
+    for (unsigned node = 0; node < nb_nodes; node++)
+        offsets[community(data, node, level) + 1]++;
+    for (unsigned c = 0; c < nb_comms; c++)
+        offsets[c + 1] += offsets[c];
+
+    //offsets[c] is used as the insertion point of c, then shifted back
+    for (unsigned node = 0; node < nb_nodes; node++)
+        members[offsets[community(data, node, level)]++] = node;
+    for (unsigned c = nb_comms; c > 0; c--)
+        offsets[c] = offsets[c - 1];
+    offsets[0] = 0;
+}
+
 
 DLL_PUBLIC const char* Communities::get_version()
 {
@@ -30,11 +30,69 @@ THE SOFTWARE.
     #define DLL_LOCAL  __attribute__ ((visibility ("hidden")))
 #endif
 
+#include <atomic>
+#include <functional>
+#include <future>
 #include <vector>
 #include <utility>
 
 namespace LouvainC {
     struct PrivateData;
+
+    //what the progress callback gets (see set_progress_callback())
+    struct Progress {
+        unsigned level;
+        //number of the pass in the level (from 1), or number of passes of
+        //the level once it is done
+        unsigned pass;
+        bool level_done;
+        //size of the graph of the level
+        unsigned long long nb_nodes;
+        unsigned long long nb_links;
+        //moves of the pass, or of the whole level once it is done
+        unsigned long long nb_moves;
+        long double quality;
+        //seconds since the start of the run
+        double elapsed;
+    };
+
+    //what happened at a level of the last run (see get_stats())
+    struct LevelStats {
+        //size of the graph of the level
+        unsigned long long nb_nodes;
+        unsigned long long nb_links;
+        unsigned nb_passes;
+        unsigned long long nb_moves;
+        long double quality_before;
+        long double quality_after;
+        //seconds spent building the quality of the graph of the level,
+        //moving its nodes, and building the graph of the next level
+        double time_quality;
+        double time_moving;
+        double time_aggregation;
+    };
+
+    struct RunStats {
+        std::vector<LevelStats> levels;
+        //seconds spent building the graph of level 0, then weighting it for
+        //the quality function, and in the whole run
+        double time_graph;
+        double time_weighting;
+        double time_total;
+        //estimated peak size of the work arrays of a level (those of the
+        //algorithm, the partition and the graph built for the next level;
+        //the arrays of the quality function are not counted)
+        unsigned long long peak_scratch_bytes;
+        bool truncated;
+    };
+
+    //an edge of a graph given to Communities::calculate_batch()
+    struct Edge {
+        unsigned src;
+        unsigned dst;
+        long double weight;
+    };
+
     #ifdef _WIN32
     class __declspec(dllexport) Communities
     #else
@@ -71,14 +129,156 @@ namespace LouvainC {
         //ONLY makes sense for id = 8
         void set_kmin(int kmin = 1);
 
+        //Keep each undirected edge only once in memory (at its smaller endpoint)
+        //instead of once per direction. Nearly halves the memory used by the
+        //input graph, at the cost of slower neighbor lookups. Results are the same.
+        void set_half_storage(bool half = true);
+
+        //Keep the adjacency lists of the input graph compressed in memory
+        //(sorted, delta and stream vbyte coded), decoded on the fly with SIMD
+        //instructions when available. Uses less memory and bandwidth on large
+        //graphs. Results are the same. Not used together with half storage.
+        void set_compressed_storage(bool compressed = true);
+
+        //Storage of the edge weights of the input graph in memory:
+        //0 = long double (default), 1 = float, 2 (3) = unsigned 16 (8) bits
+        //integers times a scale, for weights >= 0 (floats are used otherwise).
+        //Uses up to 4 times less memory for weighted graphs, results may
+        //change slightly with the precision of the weights.
+        void set_weight_storage(unsigned storage = 0);
+
+        //The edges given to add_edge() are already clean: no edge is added twice
+        //(in either direction). calculate() then skips the deduplication pass.
+        //If nb_checks > 0, that many random nodes are checked first and the
+        //graph is deduplicated anyway if one of them breaks the contract.
+        void set_trusted_input(bool trusted = true, unsigned nb_checks = 0);
+
         void set_random_seed(unsigned seed = 0);
+
+        //Removes the graph and the results, to process another graph with the
+        //same settings: the same as a new object, but the memory of the
+        //graph and of the work arrays is kept.
+        void clear();
+
+        //Time budget of calculate(), update(), calculate_best_of() and
+        //calculate_batch(), in seconds (0: no limit). The clock and the flag
+        //given to set_cancel_flag() (which another thread can set) are
+        //checked every few thousand nodes and between levels: once the time
+        //is up or the flag is true, the run stops and keeps the partition
+        //reached so far, and is_truncated() returns true until the next run
+        //(calculate_batch() returns it instead).
+        void set_time_limit(double seconds = 0.0);
+        void set_cancel_flag(const std::atomic<bool>* flag = nullptr);
+        bool is_truncated();
+
+        //f is called at the end of each pass and of each level of
+        //calculate() and update(), from the calling thread (an empty f
+        //removes it). Nothing is computed for it when it is not set.
+        void set_progress_callback(std::function<void(const Progress&)> f);
+
+        //Statistics of the last calculate(), update() or calculate_best_of()
+        //(for the run that was kept).
+        RunStats get_stats();
         void add_edge(unsigned src, unsigned dst, long double weight = 1.0L);
+
+        //Adds the variable incidence graph of a DIMACS CNF file: one node per
+        //variable, and each clause of k variables adds 1/(k*(k-1)/2) to the
+        //weight of every pair of its variables. Use calculate(true) afterwards.
+        //The file is parsed by nb_threads threads (0: one per hardware thread)
+        //With as_hyperedges, the clauses are kept as hyperedges (see below)
+        //Returns false, and adds nothing, if the file cannot be read or is not
+        //a valid DIMACS CNF (the reason is printed with verbosity on).
+        bool add_cnf(const char* filename, unsigned nb_threads = 0, bool as_hyperedges = false);
+
+        //Adds the clique over the given nodes, with the given weight on each
+        //edge, as a single hyperedge: memory stays linear in the number of
+        //nodes. Only the weighted id = 0, 5, 6 and 8 work on hyperedges
+        //directly, the other criteria (or calculate(false)) add the edges.
+        void add_hyperedge(const std::vector<unsigned>& nodes, long double weight = 1.0L);
         void calculate(bool weighted = false);
+
+        //Same as calculate(weighted), on a thread of the library: the object
+        //must not be used until the returned future is ready.
+        std::future<void> calculate_async(bool weighted = false);
+
+        //The library runs everything in parallel (the asynchronous runs, the
+        //ensemble and batch runs, the parallel loops inside a run) on a pool
+        //of nb threads shared by all the objects (0: one per hardware
+        //thread, the default). The threads calling the library also take
+        //part in their own parallel loops.
+        static void set_max_threads(unsigned nb = 0);
+
+        //Same as calculate(weighted), but level 0 starts from the given
+        //community of each node (init[node]) instead of every node alone, e.g.
+        //the result of a previous run on a slightly different graph. Any int
+        //can label a community. The nodes beyond the end of init, or with a
+        //negative community, start alone.
+        void calculate(bool weighted, const std::vector<int>& init);
+
+        //Same, from (node, community) pairs such as the ones returned by
+        //get_mapping(). The nodes missing from it start alone.
+        void calculate(bool weighted, const std::vector<std::pair<unsigned int, int>>& init);
+
+        //Ensemble mode: nb_runs runs of calculate(weighted), run i with the
+        //random seed seed + i (see set_random_seed()), and the result is the
+        //one with the best final quality (the first one on a tie). The graph
+        //of level 0 is built once and shared by the runs, which are done
+        //concurrently by nb_threads threads (0: see set_max_threads()).
+        void calculate_best_of(unsigned nb_runs, bool weighted = false, unsigned nb_threads = 0);
+
+        //Batch mode, for many small independent graphs: n2c[i] gets the
+        //community of each node of graphs[i] in the last level, the same as
+        //add_edge() of each edge of graphs[i] in order and calculate(weighted)
+        //on a new object with the same settings (quality function, precision,
+        //random seed). The graphs are spread over nb_threads threads (0: see
+        //set_max_threads()), each one reusing its buffers from one graph to
+        //the next (the graph of level 0, the graphs of the next levels, the
+        //quality function and the work arrays of the algorithm). The storage
+        //options and the edges given to add_edge() are ignored, and the state
+        //of this object (results, get_stats(), is_truncated()) is not
+        //changed. Returns true if a graph was stopped by the time budget or
+        //the cancel flag (see set_time_limit()).
+        bool calculate_batch(
+            const std::vector<std::vector<Edge>>& graphs,
+            std::vector<std::vector<int>>& n2c,
+            bool weighted = false,
+            unsigned nb_threads = 0);
+
+        //Incremental mode, after a first calculate(): the edges added with
+        //add_edge(), removed with remove_edge() or reweighted with
+        //set_edge_weight() since the last run are taken into account by
+        //update(), which starts from the last result and only moves the
+        //nodes affected by the changes at level 0 (the endpoints of the
+        //changed edges and the members of their communities, then the
+        //neighbors of each node that moves). The levels above are computed
+        //again on the (much smaller) graph of communities. The result may
+        //differ slightly from a full calculate() of the new graph.
+        void remove_edge(unsigned src, unsigned dst);
+        void set_edge_weight(unsigned src, unsigned dst, long double weight);
+        void update(bool weighted = false);
         const char* get_version();
         void set_verbosity(unsigned verb);
         void set_precision(long double precision);
         std::vector<std::pair<unsigned int, int>> get_mapping();
 
+        //Results of the last run, without any allocation: the mapping of the
+        //last level is kept once calculate() is done. level is 0 for the
+        //first level of the hierarchy, and a negative level (or one past the
+        //last) means the last level. Node ids are the ones of add_edge().
+        unsigned get_nb_nodes();
+        unsigned get_nb_levels();
+        unsigned get_nb_communities(int level = -1);
+
+        //n2c[node] is the community of node at the given level
+        //n2c must hold get_nb_nodes() ints
+        void get_mapping(int* n2c, int level = -1);
+
+        //the members of community c at the given level, in increasing order,
+        //are members[offsets[c]] ... members[offsets[c + 1] - 1]
+        //offsets must hold get_nb_communities(level) + 1 unsigned, members
+        //get_nb_nodes() unsigned
+        void get_members(unsigned* offsets, unsigned* members, int level = -1);
+
     private:
         PrivateData* data;
     };
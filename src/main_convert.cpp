@@ -30,7 +30,10 @@
 //-----------------------------------------------------------------------------
 // see README.txt for more details
 
-#include "graph_plain.h"
+#include <cstring>
+#include "graph_binary.h"
+#include "graph_csr.h"
+#include "graph_external.h"
 
 using namespace std;
 
@@ -40,12 +43,18 @@ char *outfile_w = NULL;
 char *rel = NULL;
 int type = UNWEIGHTED;
 bool do_renumber = false;
+bool format_v2 = false;
+int weight_type = GRAPH_WEIGHT_F64;
+unsigned nb_threads = 0;
+unsigned long long memory_mb = 0ULL;
+char *tmp_dir = NULL;
 
 void usage(char *prog_name, const char *more)
 {
     cerr << more;
     cerr << "usage: " << prog_name
-         << " -i input_file -o outfile [-r outfile_relation] [-w outfile_weight] [-h]" << endl
+         << " -i input_file -o outfile [-r outfile_relation] [-w outfile_weight] [-2] [-f format] [-t threads] [-m memory [-T tmp_dir]] [-h]"
+         << endl
          << endl;
     cerr << "read the graph and convert it to binary format" << endl;
     cerr << "-r file\tnodes are renumbered from 0 to nb_nodes-1 (the labelings connection is "
@@ -53,6 +62,16 @@ void usage(char *prog_name, const char *more)
          << endl;
     cerr << "-w file\tread the graph as a weighted one and writes the weights in a separate file"
          << endl;
+    cerr << "-2\twrite the single-file binary format (version " << GRAPH_VERSION
+         << "), weights included: -w then takes no file" << endl;
+    cerr << "-f fmt\tformat of the weights in the single-file binary format: f64 (default), f32, "
+            "or u16 / u8 (unsigned integers times a scale, for weights >= 0)"
+         << endl;
+    cerr << "-t nb\tnumber of threads used to parse and sort the input (one per core by default)" << endl;
+    cerr << "-m mb\tconvert out of core, with about mb megabytes of links in memory: the links "
+            "are sorted by runs in temporary files, merged into the outfile"
+         << endl;
+    cerr << "-T dir\tdirectory of the temporary files (the one of the outfile by default)" << endl;
     cerr << "-h\tshow this usage message" << endl;
     exit(0);
 }
@@ -76,7 +95,27 @@ void parse_args(int argc, char **argv)
                     break;
                 case 'w':
                     type = WEIGHTED;
-                    outfile_w = argv[i + 1];
+                    if (i < argc - 1 && argv[i + 1][0] != '-') {
+                        outfile_w = argv[i + 1];
+                        i++;
+                    }
+                    break;
+                case '2':
+                    format_v2 = true;
+                    break;
+                case 'f':
+                    if (i == argc - 1)
+                        usage(argv[0], "Weight format missing\n");
+                    if (strcmp(argv[i + 1], "f64") == 0)
+                        weight_type = GRAPH_WEIGHT_F64;
+                    else if (strcmp(argv[i + 1], "f32") == 0)
+                        weight_type = GRAPH_WEIGHT_F32;
+                    else if (strcmp(argv[i + 1], "u16") == 0)
+                        weight_type = GRAPH_WEIGHT_U16;
+                    else if (strcmp(argv[i + 1], "u8") == 0)
+                        weight_type = GRAPH_WEIGHT_U8;
+                    else
+                        usage(argv[0], "Unknown weight format\n");
                     i++;
                     break;
                 case 'r':
@@ -86,6 +125,26 @@ void parse_args(int argc, char **argv)
                     i++;
                     do_renumber = true;
                     break;
+                case 'm':
+                    if (i == argc - 1)
+                        usage(argv[0], "Memory missing\n");
+                    memory_mb = strtoull(argv[i + 1], NULL, 10);
+                    if (memory_mb == 0ULL)
+                        usage(argv[0], "Memory must be at least 1 megabyte\n");
+                    i++;
+                    break;
+                case 'T':
+                    if (i == argc - 1)
+                        usage(argv[0], "Temporary directory missing\n");
+                    tmp_dir = argv[i + 1];
+                    i++;
+                    break;
+                case 't':
+                    if (i == argc - 1)
+                        usage(argv[0], "Number of threads missing\n");
+                    nb_threads = atoi(argv[i + 1]);
+                    i++;
+                    break;
                 default:
                     usage(argv[0], "Unknown option\n");
             }
@@ -95,18 +154,42 @@ void parse_args(int argc, char **argv)
     }
     if (infile == NULL || outfile == NULL)
         usage(argv[0], "In or outfile missing\n");
+    if (type == WEIGHTED && outfile_w == NULL && !format_v2)
+        usage(argv[0], "Weight outfile missing\n");
+    if (weight_type != GRAPH_WEIGHT_F64 && !format_v2)
+        usage(argv[0], "Weight format only for the single-file binary format (-2)\n");
 }
 
 int main(int argc, char **argv)
 {
     parse_args(argc, argv);
 
-    GraphPlain g(infile, type);
+    if (memory_mb > 0ULL) {
+        string prefix = outfile;
+        if (tmp_dir != NULL) {
+            const char *name = strrchr(outfile, '/');
+            prefix = string(tmp_dir) + "/" + (name ? name + 1 : outfile);
+        }
+
+        GraphExternal g(infile, type, (size_t)(memory_mb << 20), prefix);
+
+        if (do_renumber)
+            g.renumber(rel);
+
+        if (format_v2)
+            g.display_binary_v2(outfile, weight_type);
+        else
+            g.display_binary(outfile, outfile_w);
+        return 0;
+    }
 
-    g.clean(type);
+    GraphCSR g(infile, type, nb_threads);
 
     if (do_renumber)
-        g.renumber(type, rel);
+        g.renumber(rel);
 
-    g.display_binary(outfile, outfile_w, type);
+    if (format_v2)
+        g.display_binary_v2(outfile, type, weight_type);
+    else
+        g.display_binary(outfile, outfile_w, type);
 }
@@ -33,6 +33,7 @@
 #include <unistd.h>
 #include "graph_binary.h"
 #include "graph_plain.h"
+#include "buffered_writer.h"
 #include "louvain.h"
 
 #include "balmod.h"
@@ -74,9 +75,7 @@ void print_final(vector<vector<int>>& levels)
         }
     }
 
-    for (unsigned int node = 0; node < levels[0].size(); node++) {
-        cout << node << " " << n2c[node] << endl;
-    }
+    write_partition(cout, n2c.data(), n2c.size());
 }
 
 int main(int /*argc*/, char ** /*argv*/)
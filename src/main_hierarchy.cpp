@@ -35,21 +35,35 @@
 #include <iostream>
 #include <vector>
 
+#include "buffered_writer.h"
+#include "hierarchy_tree.h"
+
 using namespace std;
 
 int display_level = -1;
 char *filename = NULL;
+char *outfile = NULL;
+bool flatten = true;
+bool raw = false;
 
 void usage(char *prog_name, const char *more)
 {
     cerr << more;
-    cerr << "usage: " << prog_name << " input_file [-l xx] [-n] [-h]" << endl << endl;
-    cerr << "input_file: read the community tree from this file" << endl;
+    cerr << "usage: " << prog_name << " input_file [-l xx [-r]] [-n] [-b outfile [-c]] [-h]" << endl
+         << endl;
+    cerr << "input_file: read the community tree from this file (text or binary format)" << endl;
     cerr << "-l xx\t display the community structure for the level xx" << endl;
     cerr << "\t outputs the community for each node" << endl;
     cerr << "\t xx must belong to [-1,N] if N is the number of levels" << endl;
+    cerr << "-r\t with -l, outputs the communities as an array of 4 bytes integers (binary)"
+         << endl;
     cerr << "-n\t displays the number of levels and the size of each level" << endl;
     cerr << "\t equivalent to -l -1" << endl;
+    cerr << "-b file\t writes the tree in the binary format, with the community of each node for "
+            "every level"
+         << endl;
+    cerr << "-c\t with -b, without the community of each node for every level (smaller file)"
+         << endl;
     cerr << "-h\tshow this usage message" << endl;
     exit(0);
 }
@@ -69,6 +83,18 @@ void parse_args(int argc, char **argv)
                 case 'n':
                     display_level = -1;
                     break;
+                case 'b':
+                    if (i == argc - 1)
+                        usage(argv[0], "Outfile missing\n");
+                    outfile = argv[i + 1];
+                    i++;
+                    break;
+                case 'c':
+                    flatten = false;
+                    break;
+                case 'r':
+                    raw = true;
+                    break;
                 case 'h':
                     usage(argv[0], "");
                     break;
@@ -90,49 +116,25 @@ int main(int argc, char **argv)
 {
     parse_args(argc, argv);
 
-    vector<vector<int> > levels;
-
-    ifstream finput;
-    finput.open(filename, fstream::in);
-    if (finput.is_open() != true) {
-        cerr << "The file " << filename << " does not exist" << endl;
-        exit(EXIT_FAILURE);
-    }
-
-    int l = -1;
-    while (!finput.eof()) {
-        int node, nodecomm;
-        finput >> node >> nodecomm;
+    HierarchyTree tree;
+    tree.read(filename);
 
-        if (finput) {
-            if (node == 0) {
-                l++;
-                levels.resize(l + 1);
-            }
-            levels[l].push_back(nodecomm);
-        }
+    if (outfile != NULL) {
+        vector<vector<int> > levels(tree.nb_levels);
+        for (int l = 0; l < tree.nb_levels; l++)
+            levels[l].assign(tree.level(l), tree.level(l) + tree.level_size(l));
+        write_tree_binary(outfile, levels, flatten);
     }
 
     if (display_level == -1) {
-        cout << "Number of levels: " << levels.size() << endl;
-        for (unsigned int i = 0; i < levels.size(); i++)
-            cout << "level " << i << ": " << levels[i].size() << " nodes" << endl;
-    } else if (display_level < 0 || (unsigned)display_level >= levels.size()) {
+        cout << "Number of levels: " << tree.nb_levels << endl;
+        for (int i = 0; i < tree.nb_levels; i++)
+            cout << "level " << i << ": " << tree.level_size(i) << " nodes" << endl;
+    } else if (display_level < 0 || display_level >= tree.nb_levels) {
         cerr << "Incorrect level\n";
     } else {
-        vector<int> n2c(levels[0].size());
-
-        for (unsigned int i = 0; i < levels[0].size(); i++)
-            n2c[i] = i;
-
-        for (l = 0; l < display_level; l++) {
-            for (unsigned int node = 0; node < levels[0].size(); node++) {
-                n2c[node] = levels[l][n2c[node]];
-            }
-        }
-
-        for (unsigned int node = 0; node < levels[0].size(); node++) {
-            cout << node << " " << n2c[node] << endl;
-        }
+        vector<int> buf;
+        const int *n2c = tree.communities(display_level, buf);
+        write_partition(cout, n2c, tree.level_size(0), raw);
     }
 }
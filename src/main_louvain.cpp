@@ -31,7 +31,9 @@
 // see README.txt for more details
 
 #include <unistd.h>
+#include <cstring>
 #include "graph_binary.h"
+#include "hierarchy_tree.h"
 #include "louvain.h"
 
 #include "balmod.h"
@@ -50,6 +52,8 @@ using namespace std;
 char *filename = NULL;
 char *filename_w = NULL;
 char *filename_part = NULL;
+bool binary_part = false;
+char *filename_tree = NULL;
 int type = UNWEIGHTED;
 
 int nb_pass = 0;
@@ -69,13 +73,16 @@ long double max_w = 1.0L;
 Quality *q;
 
 bool verbose = false;
+bool check_sum = false;
+bool compress = false;
+int weight_storage = WEIGHTS_LONG_DOUBLE;
 
 void usage(char *prog_name, const char *more)
 {
     cerr << more;
     cerr << "usage: " << prog_name
-         << " input_file [-q id_qual] [-c alpha] [-k min] [-w weight_file] [-p part_file] [-e "
-            "epsilon] [-l display_level] [-v] [-h]"
+         << " input_file [-q id_qual] [-c alpha] [-k min] [-w weight_file] [-p part_file [-r]] [-e "
+            "epsilon] [-l display_level] [-b tree_file] [-s] [-z] [-f format] [-v] [-h]"
          << endl
          << endl;
     cerr << "input_file: file containing the graph to decompose in communities" << endl;
@@ -113,14 +120,26 @@ void usage(char *prog_name, const char *more)
     cerr << endl;
 
     cerr << "-w file\tread the graph as a weighted one (weights are set to 1 otherwise)" << endl;
+    cerr << "\tsingle-file graphs (comml-convert -2) carry their weights, -w is not used" << endl;
+    cerr << "-s\tcheck the checksum of a single-file graph before using it" << endl;
+    cerr << "-z\tkeep the adjacency lists of the graph compressed in memory" << endl;
+    cerr << "-f fmt\tkeep the weights of the graph in memory as f32, u16 or u8 (unsigned integers "
+            "times a scale)"
+         << endl;
     cerr << "-p file\tstart the computation with a given partition instead of the trivial partition"
          << endl;
     cerr << "\tfile must contain lines \"node community\"" << endl;
+    cerr << "-r	the file given with -p holds the community of each node on 4 bytes (as written "
+            "by comml-hierarchy -r)"
+         << endl;
     cerr << "-e eps\ta given pass stops when the quality is increased by less than epsilon" << endl;
     cerr << "-l k\tdisplays the graph of level k rather than the hierachical structure" << endl;
     cerr << "\tif k=-1 then displays the hierarchical structure rather than the graph at a given "
             "level"
          << endl;
+    cerr << "-b file\twrites the hierarchical structure in the binary tree format (see "
+            "comml-hierarchy)"
+         << endl;
     cerr << "-v\tverbose mode: gives computation time, information about the hierarchy and quality"
          << endl;
     cerr << "-h\tshow this usage message" << endl;
@@ -157,6 +176,13 @@ void parse_args(int argc, char **argv)
                     filename_part = argv[i + 1];
                     i++;
                     break;
+                case 'r':
+                    binary_part = true;
+                    break;
+                case 'b':
+                    filename_tree = argv[i + 1];
+                    i++;
+                    break;
                 case 'e':
                     precision = atof(argv[i + 1]);
                     i++;
@@ -168,6 +194,25 @@ void parse_args(int argc, char **argv)
                 case 'v':
                     verbose = true;
                     break;
+                case 's':
+                    check_sum = true;
+                    break;
+                case 'z':
+                    compress = true;
+                    break;
+                case 'f':
+                    if (i == argc - 1)
+                        usage(argv[0], "Weight format missing\n");
+                    if (strcmp(argv[i + 1], "f32") == 0)
+                        weight_storage = WEIGHTS_F32;
+                    else if (strcmp(argv[i + 1], "u16") == 0)
+                        weight_storage = WEIGHTS_U16;
+                    else if (strcmp(argv[i + 1], "u8") == 0)
+                        weight_storage = WEIGHTS_U8;
+                    else
+                        usage(argv[0], "Unknown weight format\n");
+                    i++;
+                    break;
                 case 'h':
                     usage(argv[0], "");
                     break;
@@ -271,6 +316,14 @@ int main(int argc, char **argv)
         display_time("Begin");
 
     GraphBin g(filename, filename_w, type);
+    if (check_sum && !g.check_checksum()) {
+        cerr << "The file " << filename << " is corrupted (wrong checksum)" << endl;
+        exit(EXIT_FAILURE);
+    }
+    if (weight_storage != WEIGHTS_LONG_DOUBLE)
+        g.quantize_weights(weight_storage);
+    if (compress)
+        g.compress_links();
     init_quality(&g, nb_calls);
     nb_calls++;
 
@@ -281,7 +334,7 @@ int main(int argc, char **argv)
 
     Louvain* c = new Louvain(-1, precision, q, mtrand);
     if (filename_part != NULL)
-        c->init_partition(filename_part);
+        c->init_partition(filename_part, binary_part);
 
     bool improvement = true;
 
@@ -289,6 +342,7 @@ int main(int argc, char **argv)
     long double new_qual;
 
     int level = 0;
+    vector<vector<int> > levels;
 
     do {
         if (verbose) {
@@ -305,6 +359,10 @@ int main(int argc, char **argv)
             (c->qual)->g.display();
         if (display_level == -1)
             c->display_partition(NULL);
+        if (filename_tree != NULL) {
+            levels.push_back(vector<int>());
+            c->display_partition(&levels.back());
+        }
 
         g = c->partition2graph_binary();
         init_quality(&g, nb_calls);
@@ -327,6 +385,9 @@ int main(int argc, char **argv)
             improvement = true;
     } while (improvement);
 
+    if (filename_tree != NULL)
+        write_tree_binary(filename_tree, levels, true);
+
     time(&time_end);
     if (verbose) {
         display_time("End");
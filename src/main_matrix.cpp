@@ -30,24 +30,69 @@
 //-----------------------------------------------------------------------------
 // see README.txt for more details
 
+#include <stdint.h>
 #include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <vector>
 
+#include "buffered_writer.h"
+#include "hierarchy_tree.h"
+#include "thread_pool.h"
+
 using namespace std;
 
+// bit-packed relation file: a RelationFileHeader, then (at the given
+// positions, aligned on 64 bytes)
+//    perm: 4 bytes for each node, the nodes grouped by community (node
+//       perm[k] is at row and column k of the matrix)
+//    bounds: 8 bytes for each community and one more, community c is made
+//       of perm[bounds[c] .. bounds[c + 1])
+//    rows: row_bytes for each row k of the permuted matrix, bit j (byte j / 8,
+//       lowest bit first) is set iff perm[k] and perm[j] are in the same
+//       community
+#define RELATION_MAGIC "COMMLXB1"
+#define RELATION_VERSION 1
+#define RELATION_BYTE_ORDER 0x01020304U
+#define RELATION_ALIGN 64
+
+struct RelationFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t nb_nodes;
+    uint64_t nb_comms;
+    uint64_t row_bytes;
+    uint64_t perm_pos;
+    uint64_t bounds_pos;
+    uint64_t rows_pos;
+    uint64_t file_size;
+};
+
 int display_level = -1;
 char *filename = NULL;
+char *outfile_bits = NULL;
+bool grouped = false;
+unsigned nb_threads = 0;
 
 void usage(char *prog_name, const char *more)
 {
     cerr << more;
-    cerr << "usage: " << prog_name << " input_file [-l xx] [-n] [-h]" << endl << endl;
-    cerr << "input_file: read the community tree from this file" << endl;
+    cerr << "usage: " << prog_name << " input_file [-l xx [-g | -b outfile [-t threads]]] [-n] [-h]"
+         << endl
+         << endl;
+    cerr << "input_file: read the community tree from this file (text or binary format)" << endl;
     cerr << "-l xx\t display the X relational matrix for the level xx" << endl;
     cerr << "\t Xij = 1 iff i and j are in the same community; 0 otherwise" << endl;
     cerr << "\t xx must belong to [-1,N] if N is the number of levels" << endl;
+    cerr << "-g\t with -l, displays the blocks of X instead: a \"nb_nodes nb_communities\" line, "
+            "then a \"community size nodes...\" line for each community"
+         << endl;
+    cerr << "-b file\t with -l, writes X bit-packed in a binary file instead, nodes grouped by "
+            "community"
+         << endl;
+    cerr << "-t nb\t number of threads writing the binary file (one per core by default)" << endl;
     cerr << "-n\t displays the number of levels and the size of each level" << endl;
     cerr << "\t equivalent to -l -1" << endl;
     cerr << "-h\tshow this usage message" << endl;
@@ -69,6 +114,21 @@ void parse_args(int argc, char **argv)
                 case 'n':
                     display_level = -1;
                     break;
+                case 'g':
+                    grouped = true;
+                    break;
+                case 'b':
+                    if (i == argc - 1)
+                        usage(argv[0], "Outfile missing\n");
+                    outfile_bits = argv[i + 1];
+                    i++;
+                    break;
+                case 't':
+                    if (i == argc - 1)
+                        usage(argv[0], "Number of threads missing\n");
+                    nb_threads = atoi(argv[i + 1]);
+                    i++;
+                    break;
                 case 'h':
                     usage(argv[0], "");
                     break;
@@ -84,57 +144,175 @@ void parse_args(int argc, char **argv)
     }
     if (filename == NULL)
         usage(argv[0], "No input file has been provided\n");
+    if (grouped && outfile_bits != NULL)
+        usage(argv[0], "-g and -b cannot be used together\n");
 }
 
-int main(int argc, char **argv)
+static uint64_t align_pos(uint64_t pos)
 {
-    parse_args(argc, argv);
+    return (pos + RELATION_ALIGN - 1) / RELATION_ALIGN * RELATION_ALIGN;
+}
 
-    vector<vector<int> > levels;
+// nodes sorted by community (perm), and the start of each community in perm
+void group_nodes(const int *n2c, size_t n, vector<int>& perm, vector<uint64_t>& bounds)
+{
+    int nb_comms = 0;
+    for (size_t i = 0; i < n; i++)
+        nb_comms = max(nb_comms, n2c[i] + 1);
+
+    bounds.assign(nb_comms + 1, 0ULL);
+    for (size_t i = 0; i < n; i++)
+        bounds[n2c[i] + 1]++;
+    for (int c = 0; c < nb_comms; c++)
+        bounds[c + 1] += bounds[c];
+
+    perm.resize(n);
+    vector<uint64_t> pos(bounds.begin(), bounds.end() - 1);
+    for (size_t i = 0; i < n; i++)
+        perm[pos[n2c[i]]++] = (int)i;
+}
+
+void display_groups(const int *n2c, size_t n)
+{
+    vector<int> perm;
+    vector<uint64_t> bounds;
+    group_nodes(n2c, n, perm, bounds);
+
+    BufferedWriter out(cout);
+    out.put_int((long long)n);
+    out.put_char(' ');
+    out.put_int((long long)bounds.size() - 1);
+    out.put_char('\n');
+    for (size_t c = 0; c + 1 < bounds.size(); c++) {
+        out.put_int((long long)c);
+        out.put_char(' ');
+        out.put_int((long long)(bounds[c + 1] - bounds[c]));
+        for (uint64_t k = bounds[c]; k < bounds[c + 1]; k++) {
+            out.put_char(' ');
+            out.put_int(perm[k]);
+        }
+        out.put_char('\n');
+    }
+}
 
-    ifstream finput;
-    finput.open(filename, fstream::in);
-    if (finput.is_open() != true) {
-        cerr << "The file " << filename << " does not exist" << endl;
+// the rows of each community are all the same: ones on the columns of the
+// community, so each thread fills and writes its own range of rows
+void write_bits(const char *outfile, const int *n2c, size_t n)
+{
+    vector<int> perm;
+    vector<uint64_t> bounds;
+    group_nodes(n2c, n, perm, bounds);
+
+    RelationFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, RELATION_MAGIC, sizeof(h.magic));
+    h.version = RELATION_VERSION;
+    h.byte_order = RELATION_BYTE_ORDER;
+    h.nb_nodes = n;
+    h.nb_comms = bounds.size() - 1;
+    h.row_bytes = (n + 7) / 8;
+    h.perm_pos = align_pos(sizeof(h));
+    h.bounds_pos = align_pos(h.perm_pos + n * sizeof(int));
+    h.rows_pos = align_pos(h.bounds_pos + bounds.size() * sizeof(uint64_t));
+    h.file_size = h.rows_pos + n * h.row_bytes;
+
+    ofstream foutput;
+    foutput.open(outfile, fstream::out | fstream::binary | fstream::trunc);
+    if (foutput.is_open() != true) {
+        cerr << "The file " << outfile << " cannot be written" << endl;
+        exit(EXIT_FAILURE);
+    }
+    foutput.write((char *)&h, sizeof(h));
+    foutput.seekp(h.perm_pos);
+    foutput.write((char *)perm.data(), n * sizeof(int));
+    foutput.seekp(h.bounds_pos);
+    foutput.write((char *)bounds.data(), bounds.size() * sizeof(uint64_t));
+    if (h.file_size > h.rows_pos) {
+        foutput.seekp(h.file_size - 1);
+        foutput.put(0);
+    }
+    foutput.close();
+    if (!foutput) {
+        cerr << "The file " << outfile << " cannot be written" << endl;
         exit(EXIT_FAILURE);
     }
 
-    int l = -1;
-    while (!finput.eof()) {
-        int node, nodecomm;
-        finput >> node >> nodecomm;
+    ThreadPool::shared().set_max_threads(nb_threads);
+    size_t nb_blocks = min((size_t)ThreadPool::shared().max_threads(), max(n, (size_t)1));
+
+    vector<char> failed(nb_blocks, 0);
+    auto write_rows = [&](size_t block) {
+        size_t first = n * block / nb_blocks;
+        size_t last = n * (block + 1) / nb_blocks;
+
+        fstream f;
+        f.open(outfile, fstream::in | fstream::out | fstream::binary);
+        f.seekp(h.rows_pos + first * h.row_bytes);
 
-        if (finput) {
-            if (node == 0) {
-                l++;
-                levels.resize(l + 1);
+        // community of each row, from the bounds
+        size_t c = upper_bound(bounds.begin(), bounds.end(), (uint64_t)first) - bounds.begin() - 1;
+        size_t nb_rows = max((size_t)1, (size_t)(1 << 22) / max((size_t)h.row_bytes, (size_t)1));
+        vector<unsigned char> buf;
+        for (size_t k = first; k < last; k += nb_rows) {
+            size_t end = min(last, k + nb_rows);
+            buf.assign((end - k) * h.row_bytes, 0);
+            for (size_t r = k; r < end; r++) {
+                while (bounds[c + 1] <= r)
+                    c++;
+                unsigned char *row = &buf[(r - k) * h.row_bytes];
+                for (uint64_t j = bounds[c]; j < bounds[c + 1]; j++)
+                    row[j / 8] |= (unsigned char)(1U << (j % 8));
             }
-            levels[l].push_back(nodecomm);
+            f.write((char *)buf.data(), buf.size());
+        }
+        f.close();
+        failed[block] = !f ? 1 : 0;
+    };
+
+    ThreadPool::shared().run_parallel(nb_blocks, write_rows);
+
+    for (size_t b = 0; b < nb_blocks; b++) {
+        if (failed[b]) {
+            cerr << "The file " << outfile << " cannot be written" << endl;
+            exit(EXIT_FAILURE);
         }
     }
+}
+
+int main(int argc, char **argv)
+{
+    parse_args(argc, argv);
+
+    HierarchyTree tree;
+    tree.read(filename);
 
     if (display_level == -1) {
-        cout << "Number of levels: " << levels.size() << endl;
-        for (unsigned int i = 0; i < levels.size(); i++)
-            cout << "level " << i << ": " << levels[i].size() << " nodes" << endl;
-    } else if (display_level < 0 || (unsigned)display_level >= levels.size()) {
+        cout << "Number of levels: " << tree.nb_levels << endl;
+        for (int i = 0; i < tree.nb_levels; i++)
+            cout << "level " << i << ": " << tree.level_size(i) << " nodes" << endl;
+    } else if (display_level < 0 || display_level >= tree.nb_levels) {
         cerr << "Incorrect level\n";
     } else {
-        vector<int> n2c(levels[0].size());
-
-        for (unsigned int i = 0; i < levels[0].size(); i++)
-            n2c[i] = i;
+        vector<int> buf;
+        const int *n2c = tree.communities(display_level, buf);
+        unsigned long long n = tree.level_size(0);
 
-        for (l = 0; l < display_level; l++)
-            for (unsigned int node = 0; node < levels[0].size(); node++)
-                n2c[node] = levels[l][n2c[node]];
+        if (grouped) {
+            display_groups(n2c, n);
+            return 0;
+        }
+        if (outfile_bits != NULL) {
+            write_bits(outfile_bits, n2c, n);
+            return 0;
+        }
 
-        for (unsigned int i = 0; i < levels[0].size(); i++) {
-            for (unsigned int j = 0; j < levels[0].size(); j++) {
-                char Xij = (n2c[i] == n2c[j]) ? '1' : '0';
-                cout << Xij << " ";
+        BufferedWriter out(cout);
+        for (unsigned long long i = 0; i < n; i++) {
+            for (unsigned long long j = 0; j < n; j++) {
+                out.put_char((n2c[i] == n2c[j]) ? '1' : '0');
+                out.put_char(' ');
             }
-            cout << endl;
+            out.put_char('\n');
         }
     }
 }
@@ -0,0 +1,121 @@
+// File: main_vig.cpp
+// -- conversion of a CNF to its variable incidence graph in binary format
+//-----------------------------------------------------------------------------
+// Community detection
+// Copyright (C) 2020 Mate Soos
+//
+// This file is part of Louvain algorithm.
+//
+// Louvain algorithm is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Louvain algorithm is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Louvain algorithm.  If not, see <http://www.gnu.org/licenses/>.
+//-----------------------------------------------------------------------------
+// see README.txt for more details
+
+#include "cnf_vig.h"
+
+using namespace std;
+
+char *infile = NULL;
+char *outfile = NULL;
+char *outfile_w = NULL;
+char *rel = NULL;
+int type = UNWEIGHTED;
+bool do_renumber = false;
+unsigned nb_threads = 0;
+
+void usage(char *prog_name, const char *more)
+{
+    cerr << more;
+    cerr << "usage: " << prog_name
+         << " -i input_cnf -o outfile [-r outfile_relation] [-w outfile_weight] [-t threads] [-h]"
+         << endl
+         << endl;
+    cerr << "read a DIMACS CNF and write its variable incidence graph in binary format" << endl;
+    cerr << "(one node per variable, a clause of k variables adds 1/(k*(k-1)/2) to the "
+            "weight of each pair of its variables)"
+         << endl;
+    cerr << "-r file\tnodes are renumbered from 0 to nb_nodes-1 (the labelings connection is "
+            "stored in a separate file)"
+         << endl;
+    cerr << "-w file\twrites the weights of the graph in a separate file" << endl;
+    cerr << "-t nb\tnumber of threads used to parse the input (one per core by default)" << endl;
+    cerr << "-h\tshow this usage message" << endl;
+    exit(0);
+}
+
+void parse_args(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] == '-') {
+            switch (argv[i][1]) {
+                case 'i':
+                    if (i == argc - 1)
+                        usage(argv[0], "Infile missing\n");
+                    infile = argv[i + 1];
+                    i++;
+                    break;
+                case 'o':
+                    if (i == argc - 1)
+                        usage(argv[0], "Outfile missing\n");
+                    outfile = argv[i + 1];
+                    i++;
+                    break;
+                case 'w':
+                    if (i == argc - 1)
+                        usage(argv[0], "Weight outfile missing\n");
+                    type = WEIGHTED;
+                    outfile_w = argv[i + 1];
+                    i++;
+                    break;
+                case 'r':
+                    if (i == argc - 1)
+                        usage(argv[0], "Labelings connection outfile missing\n");
+                    rel = argv[i + 1];
+                    i++;
+                    do_renumber = true;
+                    break;
+                case 't':
+                    if (i == argc - 1)
+                        usage(argv[0], "Number of threads missing\n");
+                    nb_threads = atoi(argv[i + 1]);
+                    i++;
+                    break;
+                default:
+                    usage(argv[0], "Unknown option\n");
+            }
+        } else {
+            usage(argv[0], "More than one filename\n");
+        }
+    }
+    if (infile == NULL || outfile == NULL)
+        usage(argv[0], "In or outfile missing\n");
+}
+
+int main(int argc, char **argv)
+{
+    parse_args(argc, argv);
+
+    GraphPlain g;
+    string err;
+    if (!read_cnf_vig(infile, nb_threads, g, err)) {
+        cerr << err << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    g.clean(type);
+
+    if (do_renumber)
+        g.renumber(type, rel);
+
+    g.display_binary(outfile, outfile_w, type);
+}
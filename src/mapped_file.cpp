@@ -0,0 +1,110 @@
+// File: mapped_file.cpp
+// -- read-only memory mapped file source file
+//-----------------------------------------------------------------------------
+// Community detection
+// Copyright (C) 2020 Mate Soos
+//
+// This file is part of Louvain algorithm.
+//
+// Louvain algorithm is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Louvain algorithm is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Louvain algorithm.  If not, see <http://www.gnu.org/licenses/>.
+//-----------------------------------------------------------------------------
+// see README.txt for more details
+
+#include "mapped_file.h"
+
+#include <fstream>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+MappedFile::MappedFile() : data(NULL), size(0), mapped(false)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const char *filename, bool sequential)
+{
+    close();
+
+#if !defined(_WIN32)
+    int fd = ::open(filename, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    size = (size_t)st.st_size;
+    if (size == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    void *addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr != MAP_FAILED) {
+        if (sequential)
+            madvise(addr, size, MADV_SEQUENTIAL);
+        data = (const char *)addr;
+        mapped = true;
+        return true;
+    }
+    size = 0;
+#endif
+
+    // no mmap available (or it failed): fall back to reading the file
+    ifstream finput;
+    finput.open(filename, fstream::in | fstream::binary);
+    if (finput.is_open() != true)
+        return false;
+
+    finput.seekg(0, ios::end);
+    buffer.resize((size_t)finput.tellg());
+    finput.seekg(0, ios::beg);
+    if (!buffer.empty())
+        finput.read(&buffer[0], buffer.size());
+    if (!finput) {
+        buffer.clear();
+        return false;
+    }
+
+    size = buffer.size();
+    data = size ? &buffer[0] : NULL;
+    return true;
+}
+
+void MappedFile::close()
+{
+#if !defined(_WIN32)
+    if (mapped)
+        munmap((void *)data, size);
+#endif
+    mapped = false;
+    buffer.clear();
+    data = NULL;
+    size = 0;
+}
@@ -0,0 +1,56 @@
+// File: mapped_file.h
+// -- read-only memory mapped file header file
+//-----------------------------------------------------------------------------
+// Community detection
+// Copyright (C) 2020 Mate Soos
+//
+// This file is part of Louvain algorithm.
+//
+// Louvain algorithm is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Louvain algorithm is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Louvain algorithm.  If not, see <http://www.gnu.org/licenses/>.
+//-----------------------------------------------------------------------------
+// see README.txt for more details
+
+#ifndef LOUVAIN_MAPPEDFILE_H
+#define LOUVAIN_MAPPEDFILE_H
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+class MappedFile
+{
+   public:
+    const char *data;
+    size_t size;
+
+    MappedFile();
+    ~MappedFile();
+
+    // maps the whole file read-only into memory, sequential tells the kernel
+    // it will be read once from start to end (more read ahead)
+    // returns false if the file cannot be opened
+    // on platforms without mmap the file is read into a private buffer instead
+    bool open(const char *filename, bool sequential = true);
+    void close();
+
+   private:
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+
+    vector<char> buffer;
+    bool mapped;
+};
+
+#endif // LOUVAIN_MAPPEDFILE_H
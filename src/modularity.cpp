@@ -36,6 +36,12 @@ using namespace std;
 
 Modularity::Modularity(GraphBin& gr) : Quality(gr, "Newman-Girvan Modularity")
 {
+    reset();
+}
+
+void Modularity::reset()
+{
+    size = g.nb_nodes;
     n2c.resize(size);
 
     in.resize(size);
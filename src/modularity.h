@@ -45,6 +45,8 @@ class Modularity : public Quality
     Modularity(GraphBin& gr);
     ~Modularity();
 
+    void reset();
+
     inline void remove(int node, int comm, long double dnodecomm);
 
     inline void insert(int node, int comm, long double dnodecomm);
@@ -37,6 +37,12 @@ using namespace std;
 OwZad::OwZad(GraphBin& gr, long double al, long double max_w)
     : Quality(gr, "Owsinski-Zadrozny (with alpha=" + to_string(al) + ")"), alpha(al), max(max_w)
 {
+    reset();
+}
+
+void OwZad::reset()
+{
+    size = g.nb_nodes;
     n2c.resize(size);
 
     in.resize(size);
@@ -51,6 +51,8 @@ class OwZad : public Quality
     OwZad(GraphBin& gr, long double al, long double max_w);
     ~OwZad();
 
+    void reset();
+
     inline void remove(int node, int comm, long double dnodecomm);
 
     inline void insert(int node, int comm, long double dnodecomm);
@@ -53,6 +53,10 @@ class Quality
 
     virtual ~Quality();
 
+    // puts each node of g alone again, as the constructor does, g may have
+    // been replaced by another graph since (the vectors keep their memory)
+    virtual void reset() = 0;
+
     // remove the node from its current community with which it has dnodecomm links
     virtual void remove(int node, int comm, long double dnodecomm) = 0;
 
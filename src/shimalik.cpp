@@ -36,9 +36,15 @@ using namespace std;
 
 ShiMalik::ShiMalik(GraphBin& gr, int kappa_min)
     : Quality(gr, "Shi-Malik (with kmin=" + to_string(kappa_min) + ")"),
-      kappa(size),
       kmin(kappa_min)
 {
+    reset();
+}
+
+void ShiMalik::reset()
+{
+    size = g.nb_nodes;
+    kappa = size;
     n2c.resize(size);
 
     in.resize(size);
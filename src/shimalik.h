@@ -48,6 +48,8 @@ class ShiMalik : public Quality
     ShiMalik(GraphBin& gr, int kappa_min);
     ~ShiMalik();
 
+    void reset();
+
     inline void remove(int node, int comm, long double dnodecomm);
 
     inline void insert(int node, int comm, long double dnodecomm);
@@ -0,0 +1,142 @@
+// File: stream_vbyte.cpp
+// -- delta + stream vbyte integer compression source file
+//-----------------------------------------------------------------------------
+// Community detection
+// Copyright (C) 2020 Mate Soos
+//
+// This file is part of Louvain algorithm.
+//
+// Louvain algorithm is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Louvain algorithm is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Louvain algorithm.  If not, see <http://www.gnu.org/licenses/>.
+//-----------------------------------------------------------------------------
+// see README.txt for more details
+
+#include "stream_vbyte.h"
+
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SVB_X86_SIMD
+#include <tmmintrin.h>
+#endif
+
+// number of data bytes used by the four values of a control byte
+static unsigned char group_size[256];
+
+#ifdef SVB_X86_SIMD
+// pshufb masks moving the data bytes of a control byte to four 32 bits values
+static unsigned char group_shuffle[256][16];
+#endif
+
+static bool init_tables()
+{
+    for (int c = 0; c < 256; c++) {
+        int pos = 0;
+        for (int i = 0; i < 4; i++) {
+            int len = ((c >> (2 * i)) & 3) + 1;
+#ifdef SVB_X86_SIMD
+            for (int b = 0; b < 4; b++)
+                group_shuffle[c][4 * i + b] = (b < len) ? (unsigned char)(pos + b) : 0x80;
+#endif
+            pos += len;
+        }
+        group_size[c] = (unsigned char)pos;
+    }
+    return true;
+}
+
+static const bool tables_ready = init_tables();
+
+unsigned char *svb_encode(const uint32_t *in, uint32_t nb, uint32_t prev, unsigned char *out)
+{
+    unsigned char *ctrl = out;
+    unsigned char *data = out + (nb + 3) / 4;
+    memset(ctrl, 0, (nb + 3) / 4);
+
+    for (uint32_t i = 0; i < nb; i++) {
+        uint32_t v = in[i] - prev;
+        prev = in[i];
+
+        unsigned code = (v < (1U << 8)) ? 0 : (v < (1U << 16)) ? 1 : (v < (1U << 24)) ? 2 : 3;
+        ctrl[i / 4] |= (unsigned char)(code << (2 * (i % 4)));
+        for (unsigned b = 0; b <= code; b++)
+            *data++ = (unsigned char)(v >> (8 * b));
+    }
+    return data;
+}
+
+static const unsigned char *decode_scalar(
+    const unsigned char *ctrl,
+    const unsigned char *data,
+    uint32_t nb,
+    uint32_t prev,
+    uint32_t *out)
+{
+    for (uint32_t i = 0; i < nb; i++) {
+        unsigned code = (ctrl[i / 4] >> (2 * (i % 4))) & 3;
+        uint32_t v = 0;
+        for (unsigned b = 0; b <= code; b++)
+            v |= (uint32_t)(*data++) << (8 * b);
+        prev += v;
+        out[i] = prev;
+    }
+    return data;
+}
+
+#ifdef SVB_X86_SIMD
+__attribute__((target("ssse3"))) static const unsigned char *decode_ssse3(
+    const unsigned char *ctrl,
+    const unsigned char *data,
+    uint32_t nb,
+    uint32_t prev,
+    uint32_t *out)
+{
+    __m128i sum = _mm_set1_epi32((int)prev);
+    uint32_t i = 0;
+    for (; i + 4 <= nb; i += 4) {
+        unsigned char c = ctrl[i / 4];
+        __m128i v = _mm_loadu_si128((const __m128i *)data);
+        v = _mm_shuffle_epi8(v, _mm_loadu_si128((const __m128i *)group_shuffle[c]));
+        data += group_size[c];
+
+        // prefix sum of the four differences, plus the last value
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi32(v, sum);
+        _mm_storeu_si128((__m128i *)(out + i), v);
+        sum = _mm_shuffle_epi32(v, 0xff);
+    }
+    if (i == nb)
+        return data;
+
+    return decode_scalar(ctrl + i / 4, data, nb - i, (uint32_t)_mm_cvtsi128_si32(sum), out + i);
+}
+#endif
+
+static const unsigned char *(*select_decoder())(
+    const unsigned char *, const unsigned char *, uint32_t, uint32_t, uint32_t *)
+{
+#ifdef SVB_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("ssse3"))
+        return decode_ssse3;
+#endif
+    return decode_scalar;
+}
+
+const unsigned char *(*svb_decode)(
+    const unsigned char *ctrl,
+    const unsigned char *data,
+    uint32_t nb,
+    uint32_t prev,
+    uint32_t *out) = select_decoder();
@@ -0,0 +1,64 @@
+// File: stream_vbyte.h
+// -- delta + stream vbyte integer compression header file
+//-----------------------------------------------------------------------------
+// Community detection
+// Copyright (C) 2020 Mate Soos
+//
+// This file is part of Louvain algorithm.
+//
+// Louvain algorithm is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Louvain algorithm is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Louvain algorithm.  If not, see <http://www.gnu.org/licenses/>.
+//-----------------------------------------------------------------------------
+// see README.txt for more details
+
+#ifndef LOUVAIN_STREAMVBYTE_H
+#define LOUVAIN_STREAMVBYTE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// stream vbyte (Lemire et al.) of the differences between consecutive
+// values of a non-decreasing list:
+// (nb + 3) / 4 control bytes, each giving the size in bytes - 1 of four
+// values (2 bits each, lowest bits first), then the data bytes of the
+// values, little endian. Nothing is stored for the missing values of the
+// last control byte
+//
+// the SIMD decoder may read up to 16 bytes after the data of a list, the
+// buffer holding it must be padded with SVB_PADDING bytes
+
+#define SVB_PADDING 16
+
+// maximum size in bytes of nb encoded values
+inline size_t svb_max_size(size_t nb)
+{
+    return (nb + 3) / 4 + 4 * nb;
+}
+
+// encodes the nb values of in, differences from prev for the first one
+// returns the pointer just after the data
+unsigned char *svb_encode(const uint32_t *in, uint32_t nb, uint32_t prev, unsigned char *out);
+
+// decodes nb values, nb must be a multiple of 4 unless it is the end of the
+// list. ctrl points to the control byte of the first value, data to its first
+// data byte; the values are written to out as prev + running sum
+// returns the pointer to the data of the next value
+// (SSSE3 shuffles when the processor has them, scalar code otherwise)
+extern const unsigned char *(*svb_decode)(
+    const unsigned char *ctrl,
+    const unsigned char *data,
+    uint32_t nb,
+    uint32_t prev,
+    uint32_t *out);
+
+#endif // LOUVAIN_STREAMVBYTE_H
@@ -0,0 +1,176 @@
+// File: thread_pool.cpp
+// -- library thread pool source file
+//-----------------------------------------------------------------------------
+// Community detection
+// Copyright (C) 2020 Mate Soos
+//
+// This file is part of Louvain algorithm.
+//
+// Louvain algorithm is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Louvain algorithm is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Louvain algorithm.  If not, see <http://www.gnu.org/licenses/>.
+//-----------------------------------------------------------------------------
+// see README.txt for more details
+
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+using namespace std;
+
+// the state of a run_parallel() call, kept alive by the tasks that may start
+// after it returned
+struct ParallelJob {
+    const function<void(size_t)>* f;
+    size_t nb;
+    atomic<size_t> next;
+    mutex m;
+    condition_variable done;
+    unsigned nb_helpers;
+};
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+ThreadPool::ThreadPool() : nb_max(0), nb_running(0), stopping(false)
+{
+    set_max_threads(0);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> l(m);
+        stopping = true;
+    }
+    cv.notify_all();
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+}
+
+void ThreadPool::set_max_threads(unsigned nb)
+{
+    if (nb == 0)
+        nb = max(1U, thread::hardware_concurrency());
+
+    {
+        lock_guard<mutex> l(m);
+        nb_max = nb;
+        if (!workers.empty())
+            start_workers();
+    }
+    // the extra workers leave once idle
+    cv.notify_all();
+}
+
+unsigned ThreadPool::max_threads()
+{
+    lock_guard<mutex> l(m);
+    return nb_max;
+}
+
+void ThreadPool::start_workers()
+{
+    for (size_t i = 0; i < workers.size() && !finished.empty();) {
+        vector<thread::id>::iterator it = find(finished.begin(), finished.end(), workers[i].get_id());
+        if (it == finished.end()) {
+            i++;
+            continue;
+        }
+        finished.erase(it);
+        workers[i].join();
+        workers[i].swap(workers.back());
+        workers.pop_back();
+    }
+
+    while (nb_running < nb_max) {
+        workers.push_back(thread(&ThreadPool::work, this));
+        nb_running++;
+    }
+}
+
+void ThreadPool::work()
+{
+    unique_lock<mutex> l(m);
+    while (true) {
+        cv.wait(l, [this]() { return stopping || !tasks.empty() || nb_running > nb_max; });
+        if (stopping || (tasks.empty() && nb_running > nb_max)) {
+            finished.push_back(this_thread::get_id());
+            nb_running--;
+            return;
+        }
+
+        function<void()> task;
+        task.swap(tasks.front());
+        tasks.pop_front();
+        l.unlock();
+        task();
+        l.lock();
+    }
+}
+
+void ThreadPool::submit(function<void()> task)
+{
+    {
+        lock_guard<mutex> l(m);
+        start_workers();
+        tasks.push_back(function<void()>());
+        tasks.back().swap(task);
+    }
+    cv.notify_one();
+}
+
+void ThreadPool::run_parallel(size_t nb, const function<void(size_t)>& f)
+{
+    if (nb == 0)
+        return;
+    if (nb == 1) {
+        f(0);
+        return;
+    }
+
+    shared_ptr<ParallelJob> job = make_shared<ParallelJob>();
+    job->f = &f;
+    job->nb = nb;
+    job->next = 0;
+    job->nb_helpers = 0;
+
+    auto help = [job]() {
+        {
+            lock_guard<mutex> l(job->m);
+            if (job->next >= job->nb)
+                return;
+            job->nb_helpers++;
+        }
+        for (size_t i = job->next++; i < job->nb; i = job->next++)
+            (*job->f)(i);
+
+        lock_guard<mutex> l(job->m);
+        if (--job->nb_helpers == 0)
+            job->done.notify_all();
+    };
+
+    size_t nb_helpers = min(nb - 1, (size_t)max_threads());
+    for (size_t i = 0; i < nb_helpers; i++)
+        submit(help);
+
+    for (size_t i = job->next++; i < nb; i = job->next++)
+        f(i);
+
+    unique_lock<mutex> l(job->m);
+    job->done.wait(l, [&job]() { return job->nb_helpers == 0; });
+}
@@ -0,0 +1,80 @@
+// File: thread_pool.h
+// -- library thread pool header file
+//-----------------------------------------------------------------------------
+// Community detection
+// Copyright (C) 2020 Mate Soos
+//
+// This file is part of Louvain algorithm.
+//
+// Louvain algorithm is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Louvain algorithm is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Louvain algorithm.  If not, see <http://www.gnu.org/licenses/>.
+//-----------------------------------------------------------------------------
+// see README.txt for more details
+
+#ifndef LOUVAIN_THREADPOOL_H
+#define LOUVAIN_THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// the threads shared by everything the library runs in parallel: the
+// asynchronous runs and the parallel loops inside a run, so that several
+// concurrent jobs do not start more threads than the cap
+class ThreadPool
+{
+   public:
+    // the pool of the library, its threads are started on first use
+    static ThreadPool& shared();
+
+    ~ThreadPool();
+
+    // the pool keeps nb worker threads (0 means one per hardware thread)
+    void set_max_threads(unsigned nb);
+    unsigned max_threads();
+
+    // runs task on a worker
+    void submit(function<void()> task);
+
+    // runs f(0) ... f(nb - 1), at the same time on the idle workers: the
+    // calling thread runs the calls no worker picked up and only waits for
+    // the ones in progress, so a task of the pool can call it too
+    void run_parallel(size_t nb, const function<void(size_t)>& f);
+
+   private:
+    ThreadPool();
+    ThreadPool(const ThreadPool &);
+    ThreadPool &operator=(const ThreadPool &);
+
+    // joins the workers that left, then starts the missing ones, m must be held
+    void start_workers();
+    void work();
+
+    mutex m;
+    condition_variable cv;
+    deque<function<void()> > tasks;
+    vector<thread> workers;
+    // the workers that left after the limit was lowered, not joined yet
+    vector<thread::id> finished;
+    unsigned nb_max;
+    unsigned nb_running;
+    bool stopping;
+};
+
+#endif // LOUVAIN_THREADPOOL_H
@@ -36,6 +36,12 @@ using namespace std;
 
 Zahn::Zahn(GraphBin& gr, long double max_w) : Quality(gr, "Zahn-Condorcet"), max(max_w)
 {
+    reset();
+}
+
+void Zahn::reset()
+{
+    size = g.nb_nodes;
     n2c.resize(size);
 
     in.resize(size);
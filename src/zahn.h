@@ -48,6 +48,8 @@ class Zahn : public Quality
     Zahn(GraphBin& gr, long double max_w);
     ~Zahn();
 
+    void reset();
+
     inline void remove(int node, int comm, long double dnodecomm);
 
     inline void insert(int node, int comm, long double dnodecomm);